@@ -1,3 +1,7 @@
+#pragma once
+#include "reclaimer.hpp"
+#include "filter.hpp"
+#include "output.hpp"
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -11,15 +15,35 @@ class AVLTree
           Key key;
           Info info;
           int height;
+          bool dead;          // tombstone left behind by a lazy remove
           Node *left, *right; // left and right nodes
-          Node(const Key &key, const Info &info) : key(key), info(info), height(0), left(nullptr), right(nullptr){};
+          Node(const Key &key, const Info &info) : key(key), info(info), height(0), dead(false), left(nullptr), right(nullptr){};
      } * root; // root node
 
+     int size;        // number of allocated nodes, tombstones included
+     int tombstones;  // number of nodes marked dead
+     bool lazy;       // remove marks nodes dead instead of unlinking them
+     double max_dead; // fraction of dead nodes that triggers a rebuild
+     bool deferred;   // clear hands the nodes to the background reclaimer
+
+     BlockedBloomFilter<Key> *filter; // optional filter over the live keys, answers most misses
+
+     struct Slot
+     { // front cache entry
+          Node *node;
+          bool referenced; // hit since it was last passed over
+     };
+
+     mutable std::vector<Slot> cache; // two-way sets of recently found nodes, empty when disabled
+     int cache_bits;                  // log2 of the number of sets
+     mutable std::size_t cache_hit_count, cache_miss_count;
+
      void copy(Node *node)
      {
           if (node)
           {
-               insert(node->key, node->info);
+               if (!node->dead)
+                    insert(node->key, node->info);
                copy(node->left);
                copy(node->right);
           }
@@ -35,14 +59,148 @@ class AVLTree
           }
      }
 
-     Node *find(Node *node, const Key &key) const
+     // keep the filter in step with the live keys
+
+     void filter_insert(const Key &key)
+     {
+          if constexpr (is_hashable<Key>::value)
+               if (filter)
+               {
+                    filter->insert(key);
+                    if (filter->count() > filter->capacity())
+                         enable_filter(2 * filter->capacity());
+               }
+     }
+
+     void filter_remove(const Key &key)
+     {
+          if constexpr (is_hashable<Key>::value)
+               if (filter)
+                    filter->remove(key);
+     }
+
+     bool filter_excludes(const Key &key) const
+     {
+          if constexpr (is_hashable<Key>::value)
+               return filter and !filter->may_contain(key);
+          return false;
+     }
+
+     void filter_clear()
+     {
+          if constexpr (is_hashable<Key>::value)
+               if (filter)
+                    filter->clear();
+     }
+
+     void filter_drop()
+     {
+          if constexpr (is_hashable<Key>::value)
+               delete filter;
+          filter = nullptr;
+     }
+
+     // the front cache maps each key to a set of two slots; a slot only ever holds a live
+     // node, so a node must be forgotten before it is freed, marked dead or given another key
+
+     Slot *set(const Key &key) const
+     {
+          return &cache[2 * (std::uint64_t(std::hash<Key>{}(key)) * 0x9e3779b97f4a7c15 >> (64 - cache_bits))];
+     }
+
+     void forget(Node *node)
+     {
+          if constexpr (is_hashable<Key>::value)
+               if (!cache.empty())
+               {
+                    Slot *ways = set(node->key);
+                    for (int w = 0; w < 2; w++)
+                         if (ways[w].node == node)
+                              ways[w] = {nullptr, false};
+               }
+     }
+
+     // find through the cache, then the filter, then the tree
+     Node *lookup(const Key &key) const
+     {
+          if constexpr (is_hashable<Key>::value)
+               if (!cache.empty())
+               {
+                    Slot *ways = set(key);
+                    for (int w = 0; w < 2; w++)
+                         if (ways[w].node and ways[w].node->key == key)
+                         {
+                              cache_hit_count++;
+                              ways[w].referenced = true;
+                              return ways[w].node;
+                         }
+                    cache_miss_count++;
+                    Node *node = filter_excludes(key) ? nullptr : find(root, key);
+                    if (node)
+                    {
+                         // second chance: a slot hit since it was last passed over is kept
+                         int w = 0;
+                         if (ways[0].node and ways[0].referenced)
+                         {
+                              ways[0].referenced = false;
+                              w = 1;
+                              if (ways[1].node and ways[1].referenced)
+                              {
+                                   ways[1].referenced = false;
+                                   w = 0;
+                              }
+                         }
+                         ways[w] = {node, false};
+                    }
+                    return node;
+               }
+          if (filter_excludes(key))
+               return nullptr;
+          return find(root, key);
+     }
+
+     void fill_filter(Node *node)
      {
           if (node)
           {
-               if (node->key == key)
-                    return node;
-               Node *l = find(node->left, key), *r = find(node->right, key);
-               return l ? l : r;
+               fill_filter(node->left);
+               if (!node->dead)
+                    filter->insert(node->key);
+               fill_filter(node->right);
+          }
+     }
+
+     // free the detached subtree of node on the reclaimer thread, a chunk per step
+     static void defer_clear(Node *node, int nodes)
+     {
+          Reclaimer::instance().submit([stack = std::vector<Node *>{node}]() mutable
+                                       {
+                                            std::size_t freed = 0;
+                                            while (!stack.empty() and freed < Reclaimer::Chunk)
+                                            {
+                                                 Node *node = stack.back();
+                                                 stack.pop_back();
+                                                 if (node->right)
+                                                      stack.push_back(node->right);
+                                                 if (node->left)
+                                                      stack.push_back(node->left);
+                                                 delete node;
+                                                 freed++;
+                                            }
+                                            return freed; },
+                                       nodes);
+     }
+
+     Node *find(Node *node, const Key &key) const
+     {
+          while (node)
+          {
+               if (key < node->key)
+                    node = node->left;
+               else if (key > node->key)
+                    node = node->right;
+               else
+                    return node->dead ? nullptr : node;
           }
           return node;
      }
@@ -92,13 +250,22 @@ class AVLTree
      {
           // find the correct postion and insert the node
           if (node == nullptr)
+          {
+               size++;
                return new Node(key, info);
+          }
           if (key < node->key)
                node->left = insert(node->left, key, info);
           else if (key > node->key)
                node->right = insert(node->right, key, info);
           else
+          {
+               // revive a tombstone in place
+               node->dead = false;
+               node->info = info;
+               tombstones--;
                return node;
+          }
 
           // update the balance factor of each node and balance the tree
           node->height = 1 + std::max(height(node->left), height(node->right));
@@ -152,15 +319,22 @@ class AVLTree
                          root = nullptr;
                     }
                     else
+                    {
+                         forget(root);
                          *root = *temp;
+                    }
+                    forget(temp);
                     delete temp;
+                    size--;
                }
                else
                {
                     Node *temp = root->right;
                     while (temp->left != nullptr)
                          temp = temp->left;
+                    forget(root);
                     root->key = temp->key;
+                    root->info = temp->info;
                     root->right = remove(root->right, temp->key);
                }
           }
@@ -198,50 +372,206 @@ class AVLTree
           return root;
      }
 
-     int count(Node *node) const
+     // link the given subtrees below node and recompute its height
+     Node *attach(Node *node, Node *left, Node *right)
+     {
+          node->left = left;
+          node->right = right;
+          node->height = 1 + std::max(height(left), height(right));
+          return node;
+     }
+
+     // join two trees around a middle node whose key lies between them
+     Node *join(Node *left, Node *node, Node *right)
+     {
+          if (height(left) > height(right) + 1)
+               return join_right(left, node, right);
+          if (height(right) > height(left) + 1)
+               return join_left(left, node, right);
+          return attach(node, left, right);
+     }
+
+     // walk down the right spine of the taller left tree and rebalance on the way up
+     Node *join_right(Node *left, Node *node, Node *right)
+     {
+          Node *c = left->right;
+          if (height(c) <= height(right) + 1)
+          {
+               attach(node, c, right);
+               if (height(node) <= height(left->left) + 1)
+                    return attach(left, left->left, node);
+               return lotr(attach(left, left->left, rotr(node)));
+          }
+          attach(left, left->left, join_right(c, node, right));
+          if (height(left->right) <= height(left->left) + 1)
+               return left;
+          return lotr(left);
+     }
+
+     // walk down the left spine of the taller right tree and rebalance on the way up
+     Node *join_left(Node *left, Node *node, Node *right)
+     {
+          Node *c = right->left;
+          if (height(c) <= height(left) + 1)
+          {
+               attach(node, left, c);
+               if (height(node) <= height(right->right) + 1)
+                    return attach(right, node, right->right);
+               return rotr(attach(right, lotr(node), right->right));
+          }
+          attach(right, join_left(left, node, c), right->right);
+          if (height(right->left) <= height(right->right) + 1)
+               return right;
+          return rotr(right);
+     }
+
+     // join two trees where every key of left is smaller than every key of right
+     Node *join(Node *left, Node *right)
+     {
+          if (left == nullptr)
+               return right;
+          Node *last;
+          left = split_last(left, last);
+          return join(left, last, right);
+     }
+
+     // detach the largest node of a non-empty tree and return what is left
+     Node *split_last(Node *node, Node *&last)
+     {
+          if (node->right == nullptr)
+          {
+               last = node;
+               return node->left;
+          }
+          Node *right = split_last(node->right, last);
+          return join(node->left, node, right);
+     }
+
+     // split the tree into the keys smaller and greater than key; the node holding key
+     // itself is detached and returned, or nullptr if there is none
+     Node *split(Node *node, const Key &key, Node *&left, Node *&right)
+     {
+          if (node == nullptr)
+          {
+               left = right = nullptr;
+               return nullptr;
+          }
+          Node *found;
+          if (key < node->key)
+          {
+               found = split(node->left, key, left, right);
+               right = join(right, node, node->right);
+          }
+          else if (key > node->key)
+          {
+               found = split(node->right, key, left, right);
+               left = join(node->left, node, left);
+          }
+          else
+          {
+               left = node->left;
+               right = node->right;
+               found = attach(node, nullptr, nullptr);
+          }
+          return found;
+     }
+
+     // free a detached subtree and return the number of live keys it held
+     int discard(Node *node)
+     {
+          if (node == nullptr)
+               return 0;
+          int removed = discard(node->left) + discard(node->right);
+          if (node->dead)
+               tombstones--;
+          else
+          {
+               filter_remove(node->key);
+               forget(node);
+               removed++;
+          }
+          size--;
+          delete node;
+          return removed;
+     }
+
+     // remove the sorted keys[lo, hi) by splitting at the middle key and recursing on both halves
+     Node *remove_batch(Node *node, const std::vector<Key> &keys, std::size_t lo, std::size_t hi, int &removed)
+     {
+          if (node == nullptr or lo == hi)
+               return node;
+          std::size_t mid = lo + (hi - lo) / 2;
+          Node *left, *right;
+          removed += discard(split(node, keys[mid], left, right));
+          left = remove_batch(left, keys, lo, mid, removed);
+          right = remove_batch(right, keys, mid + 1, hi, removed);
+          return join(left, right);
+     }
+
+     // collect the live nodes in order, freeing the tombstones
+     void flatten(Node *node, std::vector<Node *> &nodes)
      {
           if (node)
-               return 1 + count(node->left) + count(node->right);
-          return 0;
+          {
+               flatten(node->left, nodes);
+               Node *right = node->right;
+               if (node->dead)
+                    delete node;
+               else
+                    nodes.push_back(node);
+               flatten(right, nodes);
+          }
+     }
+
+     // build a perfectly balanced tree from nodes[lo, hi)
+     Node *build(const std::vector<Node *> &nodes, std::size_t lo, std::size_t hi)
+     {
+          if (lo == hi)
+               return nullptr;
+          std::size_t mid = lo + (hi - lo) / 2;
+          return attach(nodes[mid], build(nodes, lo, mid), build(nodes, mid + 1, hi));
      }
 
      // print tree by inorder traversal
-     void print_inorder(Node *node) const
+     void print_inorder(Node *node, OutputBuffer &out) const
      {
           if (node)
           {
                // traverse left node
-               print_inorder(node->left);
+               print_inorder(node->left, out);
 
                // print current node data
-               std::cout << "(" << node->key << ", " << node->info
-                         << ")"
-                         << ",  ";
+               if (!node->dead)
+                    out.put('(').put(node->key).put(", ").put(node->info).put("),  ");
 
                // traverse right node
-               print_inorder(node->right);
+               print_inorder(node->right, out);
           }
      }
 
      // print the tree in graphical format
-     void print_graph(Node *root, std::string indent, const bool &last) const
+     // indent grows and shrinks back in place instead of being copied at every level
+     void print_graph(Node *root, std::string &indent, const bool &last, OutputBuffer &out) const
      {
           if (root)
           {
-               std::cout << indent;
-               if (last)
-               {
-                    std::cout << "R----";
-                    indent += "   ";
-               }
-               else
-               {
-                    std::cout << "L----";
-                    indent += "|  ";
-               }
-               std::cout << root->key << "\n";
-               print_graph(root->left, indent, false);
-               print_graph(root->right, indent, true);
+               out.put(indent).put(last ? "R----" : "L----").put(root->key).put('\n');
+               std::size_t length = indent.size();
+               indent += last ? "   " : "|  ";
+               print_graph(root->left, indent, false, out);
+               print_graph(root->right, indent, true, out);
+               indent.resize(length);
+          }
+     }
+
+     void export_elements(Node *node, OutputBuffer &out, Format format) const
+     {
+          if (node)
+          {
+               export_elements(node->left, out, format);
+               if (!node->dead)
+                    out.element(node->key, node->info, format);
+               export_elements(node->right, out, format);
           }
      }
 
@@ -251,42 +581,86 @@ class AVLTree
           {
                get_elements(elements, node->left);
 
-               elements.emplace_back(std::pair<Key, Info>(node->key, node->info));
+               if (!node->dead)
+                    elements.emplace_back(std::pair<Key, Info>(node->key, node->info));
 
                get_elements(elements, node->right);
           }
      }
 
 public:
-     AVLTree() : root(nullptr){};
+     AVLTree() : root(nullptr), size(0), tombstones(0), lazy(false), max_dead(0.25), deferred(false), filter(nullptr),
+                 cache_bits(0), cache_hit_count(0), cache_miss_count(0){};
 
-     AVLTree(const AVLTree &src)
+     AVLTree(const AVLTree &src) : root(nullptr), size(0), tombstones(0), lazy(src.lazy), max_dead(src.max_dead), deferred(src.deferred), filter(nullptr),
+                                   cache(src.cache.size(), Slot{nullptr, false}), cache_bits(src.cache_bits), cache_hit_count(0), cache_miss_count(0)
      {
-          root = nullptr;
           if (this != &src)
                copy(src.root);
+          if constexpr (is_hashable<Key>::value)
+               if (src.filter)
+                    enable_filter(src.filter->capacity());
      }
 
-     AVLTree(AVLTree &&src) : root(src.root) { src.root = nullptr; };
+     AVLTree(AVLTree &&src) : root(src.root), size(src.size), tombstones(src.tombstones), lazy(src.lazy), max_dead(src.max_dead), deferred(src.deferred), filter(src.filter),
+                              cache(std::move(src.cache)), cache_bits(src.cache_bits), cache_hit_count(src.cache_hit_count), cache_miss_count(src.cache_miss_count)
+     {
+          src.root = nullptr;
+          src.size = src.tombstones = 0;
+          src.filter = nullptr;
+          src.cache.clear();
+     };
 
      AVLTree &operator=(const AVLTree &src)
      {
-          *this = src;
+          if (this != &src)
+          {
+               AVLTree copy(src);
+               swap(copy);
+          }
+          return *this;
+     }
+
+     // the old nodes are freed by clear, so a deferred tree hands them to the reclaimer
+     AVLTree &operator=(AVLTree &&src)
+     {
+          if (this != &src)
+          {
+               clear();
+               swap(src);
+          }
+          return *this;
+     }
+
+     void swap(AVLTree &other)
+     {
+          std::swap(root, other.root);
+          std::swap(size, other.size);
+          std::swap(tombstones, other.tombstones);
+          std::swap(lazy, other.lazy);
+          std::swap(max_dead, other.max_dead);
+          std::swap(deferred, other.deferred);
+          std::swap(filter, other.filter);
+          std::swap(cache, other.cache);
+          std::swap(cache_bits, other.cache_bits);
+          std::swap(cache_hit_count, other.cache_hit_count);
+          std::swap(cache_miss_count, other.cache_miss_count);
      }
 
      ~AVLTree()
      {
           clear();
+          filter_drop();
      }
 
      bool empty() const
      {
-          return root == nullptr;
+          return count() == 0;
      }
 
      bool exists(const Key &key) const
      {
-          if (find(root, key))
+          if (lookup(key))
                return true;
           return false;
      }
@@ -296,6 +670,7 @@ public:
           if (!exists(key))
           {
                root = insert(root, key, info);
+               filter_insert(key);
                return true;
           }
           return false;
@@ -303,33 +678,100 @@ public:
 
      bool remove(const Key &key)
      {
-          if (exists(key))
+          Node *node = find(root, key);
+          if (node == nullptr)
+               return false;
+          filter_remove(key);
+          if (lazy)
           {
-               root = remove(root, key);
+               forget(node);
+               node->dead = true;
+               tombstones++;
+               if (tombstones > max_dead * size)
+                    compact();
                return true;
           }
-          return false;
+          root = remove(root, key);
+          return true;
+     }
+
+     // remove every key in [lo, hi] with two splits and one join; returns the number removed
+     int remove_range(const Key &lo, const Key &hi)
+     {
+          if (hi < lo)
+               return 0;
+          Node *left, *middle, *right;
+          Node *first = split(root, lo, left, middle);
+          Node *last = split(middle, hi, middle, right);
+          int removed = discard(first) + discard(middle) + discard(last);
+          root = join(left, right);
+          return removed;
+     }
+
+     // remove all the given keys in a single split/join pass; returns the number removed
+     int remove_batch(const std::vector<Key> &keys)
+     {
+          std::vector<Key> sorted(keys);
+          std::sort(sorted.begin(), sorted.end());
+          sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+          int removed = 0;
+          root = remove_batch(root, sorted, 0, sorted.size(), removed);
+          return removed;
+     }
+
+     // in lazy mode remove only marks nodes dead; once more than threshold of the
+     // nodes are dead the tree is rebuilt from the live ones in one pass
+     void set_lazy(bool enabled, double threshold = 0.25)
+     {
+          lazy = enabled;
+          max_dead = threshold;
+          if (!lazy and tombstones)
+               compact();
+     }
+
+     // drop all tombstones and rebuild a perfectly balanced tree
+     void compact()
+     {
+          std::vector<Node *> nodes;
+          nodes.reserve(size - tombstones);
+          flatten(root, nodes);
+          root = build(nodes, 0, nodes.size());
+          size = nodes.size();
+          tombstones = 0;
      }
 
      Info &find(const Key &key) const
      {
-          Node *node = find(root, key);
-          if (node)
-               return node->info;
+          Info *info = try_find(key);
+          if (info)
+               return *info;
           throw "Element with given key does not exist!";
      }
 
-     Info &operator[](const Key &key)
+     // like find, but a missing key gives nullptr instead of an exception
+     Info *try_find(const Key &key) const
      {
-          Node *node = find(root, key);
+          Node *node = lookup(key);
           if (node)
-               return node->info;
-          throw "Element with given key does not exist!";
+               return &node->info;
+          return nullptr;
+     }
+
+     // the info of key, or fallback when key is missing
+     Info find_or(const Key &key, const Info &fallback) const
+     {
+          Info *info = try_find(key);
+          return info ? *info : fallback;
+     }
+
+     Info &operator[](const Key &key)
+     {
+          return find(key);
      }
 
      int count() const
      {
-          return count(root);
+          return size - tombstones;
      }
 
      int height() const
@@ -337,49 +779,119 @@ public:
           return height(root);
      }
 
+     // with deferred clear the root is detached in O(1) and the nodes are freed on the
+     // background reclaimer; Reclaimer::instance().wait() blocks until they are gone
      void clear()
      {
-          clear(root);
+          if (deferred and root)
+               defer_clear(root, size);
+          else
+               clear(root);
           root = nullptr;
+          size = tombstones = 0;
+          filter_clear();
+          std::fill(cache.begin(), cache.end(), Slot{nullptr, false});
+     }
+
+     // (re)build a filter over the live keys sized for capacity keys, or twice the
+     // current count; it grows by rebuilding whenever it fills up
+     void enable_filter(std::size_t capacity = 0)
+     {
+          static_assert(is_hashable<Key>::value, "the filter needs std::hash<Key>");
+          filter_drop();
+          filter = new BlockedBloomFilter<Key>(std::max<std::size_t>(capacity, 2 * count()));
+          fill_filter(root);
+     }
+
+     void disable_filter()
+     {
+          filter_drop();
+     }
+
+     // keep a cache of about slots recently found nodes in front of the tree, for skewed
+     // lookups; const lookups then update the cache, so they must not run concurrently
+     void enable_cache(std::size_t slots = 1024)
+     {
+          static_assert(is_hashable<Key>::value, "the cache needs std::hash<Key>");
+          cache_bits = 1;
+          while ((std::size_t(2) << cache_bits) < slots)
+               cache_bits++;
+          cache.assign(std::size_t(2) << cache_bits, Slot{nullptr, false});
+          cache_hit_count = cache_miss_count = 0;
+     }
+
+     void disable_cache()
+     {
+          cache.clear();
+          cache.shrink_to_fit();
+     }
+
+     std::size_t cache_hits() const
+     {
+          return cache_hit_count;
+     }
+
+     std::size_t cache_misses() const
+     {
+          return cache_miss_count;
+     }
+
+     // clear and the destructor defer freeing the nodes; infos are then destroyed on
+     // the reclaimer thread
+     void set_deferred_clear(bool enabled)
+     {
+          deferred = enabled;
      }
 
      void print_inorder() const
      {
-          print_inorder(root);
+          OutputBuffer out;
+          print_inorder(root, out);
      }
 
      void print_graph() const
      {
-          print_graph(root, "", true);
+          OutputBuffer out;
+          std::string indent;
+          print_graph(root, indent, true, out);
+     }
+
+     // write all elements in key order to fd without building a copy of them
+     void export_elements(int fd, Format format = Format::CSV) const
+     {
+          OutputBuffer out(fd);
+          export_elements(root, out, format);
      }
 
      std::vector<std::pair<Key, Info>> get_elements() const
      {
-          std::vector<std::pair<Key, Info>> *elements = new std::vector<std::pair<Key, Info>>;
-          get_elements(*elements, root);
-          return *elements;
+          std::vector<std::pair<Key, Info>> elements;
+          elements.reserve(size - tombstones);
+          get_elements(elements, root);
+          return elements;
      }
 };
 
-AVLTree<std::string, int> &counter(const std::string &fileName)
+// add one occurrence of word
+void count_word(AVLTree<std::string, int> &dict, const std::string &word)
+{
+     int *count = dict.try_find(word);
+     if (count)
+          (*count)++;
+     else
+          dict.insert(word, 1);
+}
+
+AVLTree<std::string, int> counter(const std::string &fileName)
 {
-     AVLTree<std::string, int> *dict = new AVLTree<std::string, int>;
+     AVLTree<std::string, int> dict;
+     dict.enable_cache(1024);
      std::ifstream file(fileName);
      std::string word;
      while (file >> word)
-     {
-          try
-          {
-               (*dict)[word]++;
-          }
-          catch (const char *msg)
-          {
-               if (std::string(msg) == "Element with given key does not exist!")
-                    dict->insert(word, 1);
-          }
-     }
+          count_word(dict, word);
      file.close();
-     return *dict;
+     return dict;
 }
 
 bool compare(std::pair<std::string, int> lhs, std::pair<std::string, int> rhs)
@@ -393,6 +905,7 @@ void listing(const AVLTree<std::string, int> &src)
 {
      auto elements = src.get_elements();
      std::sort(elements.begin(), elements.end(), compare);
-     for (auto ele : elements)
-          std::cout << ele.first << ": " << ele.second << "\n";
+     OutputBuffer out;
+     for (auto &ele : elements)
+          out.put(ele.first).put(": ").put(ele.second).put('\n');
 }
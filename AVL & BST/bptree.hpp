@@ -0,0 +1,521 @@
+#pragma once
+#include "output.hpp"
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// B+tree with the AVLTree interface: every node holds up to Order keys, so a lookup
+// touches one node per level instead of one per key comparison; integer keys are
+// searched with AVX2 compares, and the linked leaves give sequential ordered scans
+template <typename Key, typename Info, int Order = 16>
+class BPlusTree
+{
+     static_assert(Order >= 8 and Order % 8 == 0, "Order must be a positive multiple of 8");
+
+     static const int Min = Order / 2; // fewest keys in any node but the root
+
+     struct alignas(64) Node
+     { // keys come first, so a search reads only the leading cache lines
+          Key keys[Order]{};
+          int n = 0; // number of keys in use
+     };
+
+     struct Leaf : Node
+     {
+          Info infos[Order]{};
+          Leaf *next = nullptr; // leaf with the following keys
+     };
+
+     struct Inner : Node
+     { // keys[i] is the smallest key under children[i + 1]
+          Node *children[Order + 1]{};
+     };
+
+     Node *root;  // leaf when levels == 0
+     Leaf *first; // leftmost leaf
+     int levels;  // number of inner levels, -1 when empty
+     int size;    // number of keys
+
+     // number of keys in keys[0, n) smaller than key
+     static int rank(const Key *keys, int n, const Key &key)
+     {
+#ifdef __AVX2__
+          if constexpr (std::is_integral<Key>::value and sizeof(Key) == 4)
+          {
+               // unsigned keys are compared as signed after flipping the sign bit
+               const __m256i bias = _mm256_set1_epi32(std::is_signed<Key>::value ? 0 : INT32_MIN);
+               const __m256i k = _mm256_xor_si256(_mm256_set1_epi32(std::int32_t(key)), bias);
+               int count = 0;
+               for (int i = 0; i < n; i += 8)
+               {
+                    __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i)), bias);
+                    unsigned less = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, v)));
+                    count += __builtin_popcount(less & ((1u << std::min(8, n - i)) - 1));
+               }
+               return count;
+          }
+          else if constexpr (std::is_integral<Key>::value and sizeof(Key) == 8)
+          {
+               const __m256i bias = _mm256_set1_epi64x(std::is_signed<Key>::value ? 0 : INT64_MIN);
+               const __m256i k = _mm256_xor_si256(_mm256_set1_epi64x(std::int64_t(key)), bias);
+               int count = 0;
+               for (int i = 0; i < n; i += 4)
+               {
+                    __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i)), bias);
+                    unsigned less = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v)));
+                    count += __builtin_popcount(less & ((1u << std::min(4, n - i)) - 1));
+               }
+               return count;
+          }
+          else
+#endif
+              if constexpr (std::is_arithmetic<Key>::value)
+          {
+               // branch-free scan, which the compiler vectorises where it can
+               int count = 0;
+               for (int i = 0; i < n; i++)
+                    count += keys[i] < key;
+               return count;
+          }
+          else
+               return std::lower_bound(keys, keys + n, key) - keys;
+     }
+
+     // index of the child of an inner node whose range contains key
+     static int route(const Node *node, const Key &key)
+     {
+          int i = rank(node->keys, node->n, key);
+          if (i < node->n and !(key < node->keys[i]))
+               i++;
+          return i;
+     }
+
+     Leaf *find_leaf(const Key &key) const
+     {
+          Node *node = root;
+          for (int level = levels; level > 0; level--)
+          {
+               Inner *inner = static_cast<Inner *>(node);
+               node = inner->children[route(inner, key)];
+          }
+          return static_cast<Leaf *>(node);
+     }
+
+     Info *lookup(const Key &key) const
+     {
+          if (root == nullptr)
+               return nullptr;
+          Leaf *leaf = find_leaf(key);
+          int i = rank(leaf->keys, leaf->n, key);
+          if (i < leaf->n and !(key < leaf->keys[i]))
+               return &leaf->infos[i];
+          return nullptr;
+     }
+
+     // insert below node; on overflow the node is split, and the new right sibling
+     // and the smallest key under it are handed back to the parent
+     bool insert(Node *node, int level, const Key &key, const Info &info, Key &separator, Node *&sibling)
+     {
+          if (level == 0)
+               return insert(static_cast<Leaf *>(node), key, info, separator, sibling);
+          Inner *inner = static_cast<Inner *>(node);
+          int c = route(inner, key);
+          Key child_separator;
+          Node *child_sibling = nullptr;
+          if (!insert(inner->children[c], level - 1, key, info, child_separator, child_sibling))
+               return false;
+          if (child_sibling)
+               insert(inner, c, child_separator, child_sibling, separator, sibling);
+          return true;
+     }
+
+     bool insert(Leaf *leaf, const Key &key, const Info &info, Key &separator, Node *&sibling)
+     {
+          int i = rank(leaf->keys, leaf->n, key);
+          if (i < leaf->n and !(key < leaf->keys[i]))
+               return false;
+          if (leaf->n == Order)
+          {
+               Leaf *right = new Leaf;
+               std::move(leaf->keys + Min, leaf->keys + Order, right->keys);
+               std::move(leaf->infos + Min, leaf->infos + Order, right->infos);
+               right->n = Order - Min;
+               leaf->n = Min;
+               right->next = leaf->next;
+               leaf->next = right;
+               sibling = right;
+               if (i > Min)
+               {
+                    leaf = right;
+                    i -= Min;
+               }
+          }
+          std::move_backward(leaf->keys + i, leaf->keys + leaf->n, leaf->keys + leaf->n + 1);
+          std::move_backward(leaf->infos + i, leaf->infos + leaf->n, leaf->infos + leaf->n + 1);
+          leaf->keys[i] = key;
+          leaf->infos[i] = info;
+          leaf->n++;
+          size++;
+          if (sibling)
+               separator = static_cast<Leaf *>(sibling)->keys[0];
+          return true;
+     }
+
+     // add child as children[c + 1] with key as keys[c], splitting a full node
+     void insert(Inner *inner, int c, const Key &key, Node *child, Key &separator, Node *&sibling)
+     {
+          if (inner->n < Order)
+          {
+               std::move_backward(inner->keys + c, inner->keys + inner->n, inner->keys + inner->n + 1);
+               std::move_backward(inner->children + c + 1, inner->children + inner->n + 1, inner->children + inner->n + 2);
+               inner->keys[c] = key;
+               inner->children[c + 1] = child;
+               inner->n++;
+               return;
+          }
+          Key keys[Order + 1];
+          Node *children[Order + 2];
+          std::move(inner->keys, inner->keys + c, keys);
+          keys[c] = key;
+          std::move(inner->keys + c, inner->keys + Order, keys + c + 1);
+          std::copy(inner->children, inner->children + c + 1, children);
+          children[c + 1] = child;
+          std::copy(inner->children + c + 1, inner->children + Order + 1, children + c + 2);
+
+          Inner *right = new Inner;
+          std::move(keys, keys + Min, inner->keys);
+          std::copy(children, children + Min + 1, inner->children);
+          inner->n = Min;
+          separator = std::move(keys[Min]);
+          std::move(keys + Min + 1, keys + Order + 1, right->keys);
+          std::copy(children + Min + 1, children + Order + 2, right->children);
+          right->n = Order - Min;
+          sibling = right;
+     }
+
+     bool remove(Node *node, int level, const Key &key)
+     {
+          if (level == 0)
+          {
+               Leaf *leaf = static_cast<Leaf *>(node);
+               int i = rank(leaf->keys, leaf->n, key);
+               if (i == leaf->n or key < leaf->keys[i])
+                    return false;
+               std::move(leaf->keys + i + 1, leaf->keys + leaf->n, leaf->keys + i);
+               std::move(leaf->infos + i + 1, leaf->infos + leaf->n, leaf->infos + i);
+               leaf->n--;
+               size--;
+               return true;
+          }
+          Inner *inner = static_cast<Inner *>(node);
+          int c = route(inner, key);
+          if (!remove(inner->children[c], level - 1, key))
+               return false;
+          if (inner->children[c]->n < Min)
+               refill(inner, c, level - 1);
+          return true;
+     }
+
+     // bring children[c] back to Min keys by borrowing from a sibling or merging with it
+     void refill(Inner *parent, int c, int level)
+     {
+          Node *left = c > 0 ? parent->children[c - 1] : nullptr;
+          Node *right = c < parent->n ? parent->children[c + 1] : nullptr;
+          if (left and left->n > Min)
+               borrow_left(parent, c, level);
+          else if (right and right->n > Min)
+               borrow_right(parent, c, level);
+          else if (left)
+               merge(parent, c - 1, level);
+          else
+               merge(parent, c, level);
+     }
+
+     void borrow_left(Inner *parent, int c, int level)
+     {
+          Node *node = parent->children[c], *left = parent->children[c - 1];
+          std::move_backward(node->keys, node->keys + node->n, node->keys + node->n + 1);
+          if (level == 0)
+          {
+               Leaf *leaf = static_cast<Leaf *>(node), *from = static_cast<Leaf *>(left);
+               std::move_backward(leaf->infos, leaf->infos + leaf->n, leaf->infos + leaf->n + 1);
+               leaf->keys[0] = std::move(from->keys[from->n - 1]);
+               leaf->infos[0] = std::move(from->infos[from->n - 1]);
+               parent->keys[c - 1] = leaf->keys[0];
+          }
+          else
+          {
+               Inner *inner = static_cast<Inner *>(node), *from = static_cast<Inner *>(left);
+               std::move_backward(inner->children, inner->children + inner->n + 1, inner->children + inner->n + 2);
+               inner->keys[0] = std::move(parent->keys[c - 1]);
+               inner->children[0] = from->children[from->n];
+               parent->keys[c - 1] = std::move(from->keys[from->n - 1]);
+          }
+          node->n++;
+          left->n--;
+     }
+
+     void borrow_right(Inner *parent, int c, int level)
+     {
+          Node *node = parent->children[c], *right = parent->children[c + 1];
+          if (level == 0)
+          {
+               Leaf *leaf = static_cast<Leaf *>(node), *from = static_cast<Leaf *>(right);
+               leaf->keys[leaf->n] = std::move(from->keys[0]);
+               leaf->infos[leaf->n] = std::move(from->infos[0]);
+               std::move(from->keys + 1, from->keys + from->n, from->keys);
+               std::move(from->infos + 1, from->infos + from->n, from->infos);
+               parent->keys[c] = from->keys[0];
+          }
+          else
+          {
+               Inner *inner = static_cast<Inner *>(node), *from = static_cast<Inner *>(right);
+               inner->keys[inner->n] = std::move(parent->keys[c]);
+               inner->children[inner->n + 1] = from->children[0];
+               parent->keys[c] = std::move(from->keys[0]);
+               std::move(from->keys + 1, from->keys + from->n, from->keys);
+               std::copy(from->children + 1, from->children + from->n + 1, from->children);
+          }
+          node->n++;
+          right->n--;
+     }
+
+     // merge children[i + 1] into children[i] and drop it from the parent
+     void merge(Inner *parent, int i, int level)
+     {
+          Node *left = parent->children[i], *right = parent->children[i + 1];
+          if (level == 0)
+          {
+               Leaf *into = static_cast<Leaf *>(left), *from = static_cast<Leaf *>(right);
+               std::move(from->keys, from->keys + from->n, into->keys + into->n);
+               std::move(from->infos, from->infos + from->n, into->infos + into->n);
+               into->n += from->n;
+               into->next = from->next;
+               delete from;
+          }
+          else
+          {
+               Inner *into = static_cast<Inner *>(left), *from = static_cast<Inner *>(right);
+               into->keys[into->n] = std::move(parent->keys[i]);
+               std::move(from->keys, from->keys + from->n, into->keys + into->n + 1);
+               std::copy(from->children, from->children + from->n + 1, into->children + into->n + 1);
+               into->n += from->n + 1;
+               delete from;
+          }
+          std::move(parent->keys + i + 1, parent->keys + parent->n, parent->keys + i);
+          std::copy(parent->children + i + 2, parent->children + parent->n + 1, parent->children + i + 1);
+          parent->n--;
+     }
+
+     void clear(Node *node, int level)
+     {
+          if (level == 0)
+          {
+               delete static_cast<Leaf *>(node);
+               return;
+          }
+          Inner *inner = static_cast<Inner *>(node);
+          for (int i = 0; i <= inner->n; i++)
+               clear(inner->children[i], level - 1);
+          delete inner;
+     }
+
+     // copy a subtree, threading its leaves after last
+     Node *copy(const Node *node, int level, Leaf *&last)
+     {
+          if (level == 0)
+          {
+               Leaf *leaf = new Leaf(*static_cast<const Leaf *>(node));
+               leaf->next = nullptr;
+               if (last)
+                    last->next = leaf;
+               else
+                    first = leaf;
+               last = leaf;
+               return leaf;
+          }
+          const Inner *src = static_cast<const Inner *>(node);
+          Inner *inner = new Inner(*src);
+          for (int i = 0; i <= src->n; i++)
+               inner->children[i] = copy(src->children[i], level - 1, last);
+          return inner;
+     }
+
+public:
+     BPlusTree() : root(nullptr), first(nullptr), levels(-1), size(0){};
+
+     BPlusTree(const BPlusTree &src) : root(nullptr), first(nullptr), levels(src.levels), size(src.size)
+     {
+          Leaf *last = nullptr;
+          if (src.root)
+               root = copy(src.root, levels, last);
+     }
+
+     BPlusTree(BPlusTree &&src) : root(src.root), first(src.first), levels(src.levels), size(src.size)
+     {
+          src.root = src.first = nullptr;
+          src.levels = -1;
+          src.size = 0;
+     }
+
+     BPlusTree &operator=(const BPlusTree &src)
+     {
+          if (this != &src)
+          {
+               BPlusTree copy(src);
+               std::swap(root, copy.root);
+               std::swap(first, copy.first);
+               std::swap(levels, copy.levels);
+               std::swap(size, copy.size);
+          }
+          return *this;
+     }
+
+     ~BPlusTree()
+     {
+          clear();
+     }
+
+     bool empty() const
+     {
+          return size == 0;
+     }
+
+     bool exists(const Key &key) const
+     {
+          return lookup(key) != nullptr;
+     }
+
+     bool insert(const Key &key, const Info &info)
+     {
+          if (root == nullptr)
+          {
+               first = new Leaf;
+               root = first;
+               levels = 0;
+          }
+          Key separator;
+          Node *sibling = nullptr;
+          if (!insert(root, levels, key, info, separator, sibling))
+               return false;
+          if (sibling)
+          {
+               // the root split: the tree grows by one level
+               Inner *top = new Inner;
+               top->keys[0] = std::move(separator);
+               top->children[0] = root;
+               top->children[1] = sibling;
+               top->n = 1;
+               root = top;
+               levels++;
+          }
+          return true;
+     }
+
+     bool remove(const Key &key)
+     {
+          if (root == nullptr or !remove(root, levels, key))
+               return false;
+          if (levels > 0 and root->n == 0)
+          {
+               // the root lost its last separator: the tree shrinks by one level
+               Inner *top = static_cast<Inner *>(root);
+               root = top->children[0];
+               delete top;
+               levels--;
+          }
+          else if (levels == 0 and root->n == 0)
+          {
+               delete static_cast<Leaf *>(root);
+               root = first = nullptr;
+               levels = -1;
+          }
+          return true;
+     }
+
+     Info &find(const Key &key) const
+     {
+          Info *info = lookup(key);
+          if (info)
+               return *info;
+          throw "Element with given key does not exist!";
+     }
+
+     // like find, but a missing key gives nullptr instead of an exception
+     Info *try_find(const Key &key) const
+     {
+          return lookup(key);
+     }
+
+     // the info of key, or fallback when key is missing
+     Info find_or(const Key &key, const Info &fallback) const
+     {
+          Info *info = lookup(key);
+          return info ? *info : fallback;
+     }
+
+     Info &operator[](const Key &key)
+     {
+          return find(key);
+     }
+
+     int count() const
+     {
+          return size;
+     }
+
+     // number of levels below the root, -1 for an empty tree
+     int height() const
+     {
+          return levels;
+     }
+
+     void clear()
+     {
+          if (root)
+               clear(root, levels);
+          root = first = nullptr;
+          levels = -1;
+          size = 0;
+     }
+
+     // same format as AVLTree::print_inorder
+     void print_inorder() const
+     {
+          OutputBuffer out;
+          for (Leaf *leaf = first; leaf; leaf = leaf->next)
+               for (int i = 0; i < leaf->n; i++)
+                    out.put('(').put(leaf->keys[i]).put(", ").put(leaf->infos[i]).put("),  ");
+     }
+
+     std::vector<std::pair<Key, Info>> get_elements() const
+     {
+          std::vector<std::pair<Key, Info>> elements;
+          elements.reserve(size);
+          for (Leaf *leaf = first; leaf; leaf = leaf->next)
+               for (int i = 0; i < leaf->n; i++)
+                    elements.emplace_back(leaf->keys[i], leaf->infos[i]);
+          return elements;
+     }
+
+     // elements with keys in [lo, hi], read along the leaf chain
+     std::vector<std::pair<Key, Info>> get_elements(const Key &lo, const Key &hi) const
+     {
+          std::vector<std::pair<Key, Info>> elements;
+          if (root == nullptr)
+               return elements;
+          Leaf *leaf = find_leaf(lo);
+          for (int i = rank(leaf->keys, leaf->n, lo); leaf; leaf = leaf->next, i = 0)
+               for (; i < leaf->n; i++)
+               {
+                    if (hi < leaf->keys[i])
+                         return elements;
+                    elements.emplace_back(leaf->keys[i], leaf->infos[i]);
+               }
+          return elements;
+     }
+};
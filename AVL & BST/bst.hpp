@@ -1,4 +1,6 @@
+#include "output.hpp"
 #include <iostream>
+#include <string>
 
 template <typename Key, typename Info>
 class BinarySearchTree
@@ -115,42 +117,33 @@ class BinarySearchTree
      }
 
      // print tree by inorder traversal
-     void print_inorder(Node *node) const
+     void print_inorder(Node *node, OutputBuffer &out) const
      {
           if (node)
           {
                // traverse left node
-               print_inorder(node->left);
+               print_inorder(node->left, out);
 
                // print current node data
-               std::cout << "(" << node->key << ", " << node->info
-                         << ")"
-                         << ",  ";
+               out.put('(').put(node->key).put(", ").put(node->info).put("),  ");
 
                // traverse right node
-               print_inorder(node->right);
+               print_inorder(node->right, out);
           }
      }
 
      // print the tree in graphical format
-     void print_graph(Node *root, std::string indent, const bool &last) const
+     // indent grows and shrinks back in place instead of being copied at every level
+     void print_graph(Node *root, std::string &indent, const bool &last, OutputBuffer &out) const
      {
           if (root)
           {
-               std::cout << indent;
-               if (last)
-               {
-                    std::cout << "R----";
-                    indent += "   ";
-               }
-               else
-               {
-                    std::cout << "L----";
-                    indent += "|  ";
-               }
-               std::cout << root->key << "\n";
-               print_graph(root->left, indent, false);
-               print_graph(root->right, indent, true);
+               out.put(indent).put(last ? "R----" : "L----").put(root->key).put('\n');
+               std::size_t length = indent.size();
+               indent += last ? "   " : "|  ";
+               print_graph(root->left, indent, false, out);
+               print_graph(root->right, indent, true, out);
+               indent.resize(length);
           }
      }
 
@@ -210,18 +203,31 @@ public:
 
      Info &find(const Key &key) const
      {
-          Node *node = find(root, key);
-          if (node)
-               return node->info;
+          Info *info = try_find(key);
+          if (info)
+               return *info;
           throw "Element with given key does not exist!";
      }
 
-     Info &operator[](const Key &key)
+     // like find, but a missing key gives nullptr instead of an exception
+     Info *try_find(const Key &key) const
      {
           Node *node = find(root, key);
           if (node)
-               return node->info;
-          throw "Element with given key does not exist!";
+               return &node->info;
+          return nullptr;
+     }
+
+     // the info of key, or fallback when key is missing
+     Info find_or(const Key &key, const Info &fallback) const
+     {
+          Info *info = try_find(key);
+          return info ? *info : fallback;
+     }
+
+     Info &operator[](const Key &key)
+     {
+          return find(key);
      }
 
      int count() const
@@ -242,11 +248,14 @@ public:
 
      void print_inorder() const
      {
-          print_inorder(root);
+          OutputBuffer out;
+          print_inorder(root, out);
      }
 
      void print_graph() const
      {
-          print_graph(root, "", true);
+          OutputBuffer out;
+          std::string indent;
+          print_graph(root, indent, true, out);
      }
 };
@@ -0,0 +1,758 @@
+#pragma once
+#include "filter.hpp"
+#include "output.hpp"
+#include <vector>
+#include <optional>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+// AVL tree tuned for insert-heavy ingestion: updates are appended to a root buffer and
+// pushed one level down, in batches, whenever a node's buffer fills up; for hashable keys
+// a direct-mapped combiner in front of the root buffer folds increments of the same key
+// together before they are ever sorted
+template <typename Key, typename Info>
+class BufferedAVLTree
+{
+     enum Kind
+     {
+          Insert, // insert if absent
+          Add,    // add to the info, insert if absent
+          Remove  // remove if present
+     };
+
+     struct Message
+     { // pending update travelling down the tree
+          Kind kind;
+          Key key;
+          Info info;
+          Message(Kind kind, const Key &key, const Info &info) : kind(kind), key(key), info(info){};
+     };
+
+     struct Node
+     { // node structure
+          Key key;
+          Info info;
+          int height;
+          bool dead;                   // removed, kept as a tombstone until the next compaction
+          std::vector<Message> buffer; // messages for keys of this subtree, sorted by key, oldest first
+          Node *left, *right;          // left and right nodes
+          Node(const Key &key, const Info &info) : key(key), info(info), height(0), dead(false), left(nullptr), right(nullptr){};
+     } * root; // root node
+
+     std::vector<std::optional<Message>> combiner; // newest message of each key hashed to a slot, empty for unhashable keys
+     std::vector<Message> inbox; // newest messages in arrival order, in front of the root
+     std::size_t capacity;       // buffer length that triggers a flush
+     int size;             // number of nodes, tombstones included
+     int tombstones;       // number of dead nodes
+     std::size_t pending;  // number of messages in the inbox and the buffers
+
+     Node *copy(const Node *node)
+     {
+          if (node == nullptr)
+               return nullptr;
+          Node *dup = new Node(*node);
+          dup->left = copy(node->left);
+          dup->right = copy(node->right);
+          return dup;
+     }
+
+     void clear(Node *node)
+     {
+          if (node)
+          {
+               clear(node->left);
+               clear(node->right);
+               delete node;
+          }
+     }
+
+     Node *find(Node *node, const Key &key) const
+     {
+          while (node)
+          {
+               if (key < node->key)
+                    node = node->left;
+               else if (key > node->key)
+                    node = node->right;
+               else
+                    return node;
+          }
+          return node;
+     }
+
+     // calculate height
+     int height(const Node *node) const
+     {
+          if (node)
+               return node->height;
+          return -1;
+     }
+
+     // link the given subtrees below node and recompute its height
+     Node *attach(Node *node, Node *left, Node *right)
+     {
+          node->left = left;
+          node->right = right;
+          node->height = 1 + std::max(height(left), height(right));
+          return node;
+     }
+
+     static bool by_key(const Message &lhs, const Message &rhs)
+     {
+          return lhs.key < rhs.key;
+     }
+
+     // append a newer sorted run to a sorted buffer, older messages first among equal keys
+     static void merge(std::vector<Message> &buffer, std::vector<Message> &messages)
+     {
+          std::size_t mid = buffer.size();
+          buffer.insert(buffer.end(), std::make_move_iterator(messages.begin()), std::make_move_iterator(messages.end()));
+          std::inplace_merge(buffer.begin(), buffer.begin() + mid, buffer.end(), by_key);
+     }
+
+     // the node moving up inherits the buffer of the node moving down; its own
+     // messages passed through that node earlier, so they count as older
+     void hoist(Node *top, Node *below)
+     {
+          merge(top->buffer, below->buffer);
+          below->buffer.clear();
+     }
+
+     // rotate right
+     Node *rotr(Node *y)
+     {
+          Node *x = y->left;
+          attach(y, x->right, y->right);
+          attach(x, x->left, y);
+          hoist(x, y);
+          return x;
+     }
+
+     // rotate left
+     Node *lotr(Node *x)
+     {
+          Node *y = x->right;
+          attach(x, x->left, y->left);
+          attach(y, x, y->right);
+          hoist(y, x);
+          return y;
+     }
+
+     // join two trees around a middle node with an empty buffer
+     Node *join(Node *left, Node *node, Node *right)
+     {
+          if (height(left) > height(right) + 1)
+               return join_right(left, node, right);
+          if (height(right) > height(left) + 1)
+               return join_left(left, node, right);
+          return attach(node, left, right);
+     }
+
+     Node *join_right(Node *left, Node *node, Node *right)
+     {
+          Node *c = left->right;
+          if (height(c) <= height(right) + 1)
+          {
+               attach(node, c, right);
+               if (height(node) <= height(left->left) + 1)
+                    return attach(left, left->left, node);
+               return lotr(attach(left, left->left, rotr(node)));
+          }
+          attach(left, left->left, join_right(c, node, right));
+          if (height(left->right) <= height(left->left) + 1)
+               return left;
+          return lotr(left);
+     }
+
+     Node *join_left(Node *left, Node *node, Node *right)
+     {
+          Node *c = right->left;
+          if (height(c) <= height(left) + 1)
+          {
+               attach(node, left, c);
+               if (height(node) <= height(right->right) + 1)
+                    return attach(right, node, right->right);
+               return rotr(attach(right, lotr(node), right->right));
+          }
+          attach(right, join_left(left, node, c), right->right);
+          if (height(right->left) <= height(right->right) + 1)
+               return right;
+          return rotr(right);
+     }
+
+     // insert a key known to be absent and rebalance
+     Node *insert(Node *node, const Key &key, const Info &info)
+     {
+          if (node == nullptr)
+          {
+               size++;
+               return new Node(key, info);
+          }
+          if (key < node->key)
+               node->left = insert(node->left, key, info);
+          else
+               node->right = insert(node->right, key, info);
+          return balance(node);
+     }
+
+     // restore the balance of a node whose subtrees differ in height by at most two
+     Node *balance(Node *node)
+     {
+          attach(node, node->left, node->right);
+          int b = height(node->left) - height(node->right);
+          if (b > 1)
+          {
+               if (height(node->left->left) < height(node->left->right))
+                    node->left = lotr(node->left);
+               return rotr(node);
+          }
+          if (b < -1)
+          {
+               if (height(node->right->right) < height(node->right->left))
+                    node->right = rotr(node->right);
+               return lotr(node);
+          }
+          return node;
+     }
+
+     // apply a message to a value that may or may not be present
+     static void apply(const Message &msg, bool &present, Info &info)
+     {
+          switch (msg.kind)
+          {
+          case Insert:
+               if (!present)
+                    info = msg.info;
+               present = true;
+               break;
+          case Add:
+               if (present)
+                    info += msg.info;
+               else
+                    info = msg.info;
+               present = true;
+               break;
+          case Remove:
+               present = false;
+          }
+     }
+
+     // apply a message to the node holding its key
+     void apply(Node *node, const Message &msg)
+     {
+          bool present = !node->dead;
+          apply(msg, present, node->info);
+          if (present == node->dead)
+          {
+               tombstones += present ? -1 : 1;
+               node->dead = !present;
+          }
+     }
+
+     // fold increments and overwritten updates of key-sorted messages together
+     static void coalesce(std::vector<Message> &messages)
+     {
+          std::size_t out = 0;
+          for (std::size_t i = 0; i < messages.size(); i++)
+          {
+               Message &msg = messages[i];
+               if (msg.kind == Remove)
+                    while (out > 0 and messages[out - 1].key == msg.key)
+                         out--;
+               else if (out > 0 and messages[out - 1].key == msg.key and messages[out - 1].kind == Add and msg.kind == Add)
+               {
+                    messages[out - 1].info += msg.info;
+                    continue;
+               }
+               if (out != i)
+                    messages[out] = std::move(msg);
+               out++;
+          }
+          messages.erase(messages.begin() + out, messages.end());
+     }
+
+     // like coalesce, for messages counted in pending
+     void coalesce_pending(std::vector<Message> &messages)
+     {
+          std::size_t before = messages.size();
+          coalesce(messages);
+          pending -= before - messages.size();
+     }
+
+     // turn sorted messages for keys absent from the tree into a balanced subtree
+     Node *build(const std::vector<Message> &messages)
+     {
+          std::vector<Node *> nodes;
+          for (std::size_t i = 0; i < messages.size();)
+          {
+               bool present = false;
+               Info info{};
+               std::size_t j = i;
+               for (; j < messages.size() and messages[j].key == messages[i].key; j++)
+                    apply(messages[j], present, info);
+               if (present)
+                    nodes.push_back(new Node(messages[i].key, info));
+               i = j;
+          }
+          size += nodes.size();
+          pending -= messages.size();
+          return build(nodes, 0, nodes.size());
+     }
+
+     // build a perfectly balanced tree from nodes[lo, hi)
+     Node *build(const std::vector<Node *> &nodes, std::size_t lo, std::size_t hi)
+     {
+          if (lo == hi)
+               return nullptr;
+          std::size_t mid = lo + (hi - lo) / 2;
+          return attach(nodes[mid], build(nodes, lo, mid), build(nodes, mid + 1, hi));
+     }
+
+     // hand messages to a child, flushing it in turn if its buffer overflows
+     Node *push(Node *node, std::vector<Message> &messages)
+     {
+          if (messages.empty())
+               return node;
+          if (node == nullptr)
+               return build(messages);
+          merge(node->buffer, messages);
+          if (node->buffer.size() > capacity)
+               return flush(node);
+          return node;
+     }
+
+     // move the node's buffer one level down and rebalance the subtree
+     Node *flush(Node *node)
+     {
+          std::vector<Message> messages, left, right;
+          messages.swap(node->buffer);
+          coalesce_pending(messages);
+          for (auto &msg : messages)
+          {
+               if (msg.key < node->key)
+                    left.push_back(std::move(msg));
+               else if (msg.key > node->key)
+                    right.push_back(std::move(msg));
+               else
+               {
+                    apply(node, msg);
+                    pending--;
+               }
+          }
+          Node *l = push(node->left, left), *r = push(node->right, right);
+          return join(l, node, r);
+     }
+
+     // flush every buffer of the subtree down to the nodes
+     Node *flush_all(Node *node)
+     {
+          if (node == nullptr)
+               return node;
+          while (!node->buffer.empty())
+               node = flush(node);
+          Node *l = flush_all(node->left), *r = flush_all(node->right);
+          return join(l, node, r);
+     }
+
+     // collect the live nodes in order, freeing the tombstones
+     void flatten(Node *node, std::vector<Node *> &nodes)
+     {
+          if (node)
+          {
+               flatten(node->left, nodes);
+               Node *right = node->right;
+               if (node->dead)
+                    delete node;
+               else
+                    nodes.push_back(node);
+               flatten(right, nodes);
+          }
+     }
+
+     // search path of key, ending with the node holding it if there is one
+     template <typename NodePtr>
+     static std::vector<NodePtr> path(NodePtr node, const Key &key)
+     {
+          std::vector<NodePtr> nodes;
+          while (node)
+          {
+               nodes.push_back(node);
+               if (key < node->key)
+                    node = node->left;
+               else if (key > node->key)
+                    node = node->right;
+               else
+                    break;
+          }
+          return nodes;
+     }
+
+     // fold the stored state of key with the messages pending on its search path
+     bool lookup(const Key &key, Info &info) const
+     {
+          std::vector<const Node *> nodes = path<const Node *>(root, key);
+          bool present = false;
+          if (!nodes.empty() and nodes.back()->key == key and !nodes.back()->dead)
+          {
+               present = true;
+               info = nodes.back()->info;
+          }
+          for (auto it = nodes.rbegin(); it != nodes.rend(); ++it)
+               for (auto &msg : (*it)->buffer)
+                    if (msg.key == key)
+                         apply(msg, present, info);
+          for (auto &msg : inbox)
+               if (msg.key == key)
+                    apply(msg, present, info);
+          std::size_t i = slot(key);
+          if (i < combiner.size() and combiner[i] and combiner[i]->key == key)
+               apply(*combiner[i], present, info);
+          return present;
+     }
+
+     // slot of the combiner for key, combiner.size() when there is no combiner
+     std::size_t slot(const Key &key) const
+     {
+          if constexpr (is_hashable<Key>::value)
+               if (!combiner.empty())
+                    return std::hash<Key>{}(key) & (combiner.size() - 1);
+          return combiner.size();
+     }
+
+     // move the messages for key out of buffer, keeping the order of the rest
+     static void extract(std::vector<Message> &buffer, const Key &key, std::vector<Message> &messages)
+     {
+          auto first = std::stable_partition(buffer.begin(), buffer.end(), [&key](const Message &msg)
+                                             { return !(msg.key == key); });
+          messages.insert(messages.end(), std::make_move_iterator(first), std::make_move_iterator(buffer.end()));
+          buffer.erase(first, buffer.end());
+     }
+
+     // apply all messages pending for key to its node, creating it if needed
+     Node *resolve(const Key &key)
+     {
+          std::vector<Node *> nodes = path<Node *>(root, key);
+          std::vector<Message> messages;
+          for (auto it = nodes.rbegin(); it != nodes.rend(); ++it)
+               extract((*it)->buffer, key, messages);
+          extract(inbox, key, messages);
+          std::size_t i = slot(key);
+          if (i < combiner.size() and combiner[i] and combiner[i]->key == key)
+          {
+               messages.push_back(std::move(*combiner[i]));
+               combiner[i].reset();
+          }
+          pending -= messages.size();
+          if (!nodes.empty() and nodes.back()->key == key)
+          {
+               Node *node = nodes.back();
+               for (auto &msg : messages)
+                    apply(node, msg);
+               return node->dead ? nullptr : node;
+          }
+          bool present = false;
+          Info info{};
+          for (auto &msg : messages)
+               apply(msg, present, info);
+          if (!present)
+               return nullptr;
+          root = insert(root, key, info);
+          return find(root, key);
+     }
+
+     // queue a message in front of the root
+     void post(Kind kind, const Key &key, const Info &info)
+     {
+          std::size_t i = slot(key);
+          if (i == combiner.size())
+          {
+               inbox.emplace_back(kind, key, info);
+               pending++;
+          }
+          else if (combiner[i] and combiner[i]->key == key and combiner[i]->kind == Add and kind == Add)
+          {
+               combiner[i]->info += info;
+               return;
+          }
+          else
+          {
+               // the message in the slot is older than the new one, so it goes to the inbox first
+               if (combiner[i])
+                    inbox.push_back(std::move(*combiner[i]));
+               else
+                    pending++;
+               combiner[i].emplace(kind, key, info);
+          }
+          if (inbox.size() > capacity)
+          {
+               drain();
+               if (tombstones > size / 2)
+                    compact();
+          }
+     }
+
+     // sort the inbox and hand it to the root
+     void drain()
+     {
+          for (auto &slot : combiner)
+               if (slot)
+               {
+                    inbox.push_back(std::move(*slot));
+                    slot.reset();
+               }
+          std::stable_sort(inbox.begin(), inbox.end(), by_key);
+          root = push(root, inbox);
+          inbox.clear();
+     }
+
+     void collect(const Node *node, int depth, std::vector<const Node *> &nodes, std::vector<std::pair<int, const Message *>> &pending) const
+     {
+          if (node)
+          {
+               for (auto &msg : node->buffer)
+                    pending.emplace_back(depth, &msg);
+               collect(node->left, depth + 1, nodes, pending);
+               nodes.push_back(node);
+               collect(node->right, depth + 1, nodes, pending);
+          }
+     }
+
+     // visit the live elements in key order, merging the stored nodes with the pending
+     // messages, which are ordered by key and then from the deepest (oldest) buffer up;
+     // stops as soon as visit returns false
+     template <typename Visit>
+     void for_each_element(Visit visit) const
+     {
+          std::vector<const Node *> nodes;
+          std::vector<std::pair<int, const Message *>> pending;
+          collect(root, 0, nodes, pending);
+          for (auto &msg : inbox)
+               pending.emplace_back(-1, &msg);
+          for (auto &slot : combiner)
+               if (slot)
+                    pending.emplace_back(-2, &*slot);
+          std::stable_sort(pending.begin(), pending.end(), [](const std::pair<int, const Message *> &lhs, const std::pair<int, const Message *> &rhs)
+                           {
+                                if (lhs.second->key < rhs.second->key)
+                                     return true;
+                                if (rhs.second->key < lhs.second->key)
+                                     return false;
+                                return lhs.first > rhs.first; });
+
+          std::size_t i = 0, j = 0;
+          while (i < nodes.size() or j < pending.size())
+          {
+               const Key &key = (i < nodes.size() and (j == pending.size() or !(pending[j].second->key < nodes[i]->key))) ? nodes[i]->key : pending[j].second->key;
+               bool present = false;
+               Info info{};
+               if (i < nodes.size() and nodes[i]->key == key)
+               {
+                    present = !nodes[i]->dead;
+                    info = nodes[i]->info;
+                    i++;
+               }
+               for (; j < pending.size() and pending[j].second->key == key; j++)
+                    apply(*pending[j].second, present, info);
+               if (present and !visit(key, info))
+                    return;
+          }
+     }
+
+public:
+     // the combiner gets a power of two slots, at least capacity
+     BufferedAVLTree(std::size_t capacity = 1024) : root(nullptr), capacity(capacity), size(0), tombstones(0), pending(0)
+     {
+          if constexpr (is_hashable<Key>::value)
+          {
+               std::size_t slots = 1;
+               while (slots < capacity)
+                    slots *= 2;
+               combiner.resize(slots);
+          }
+     };
+
+     BufferedAVLTree(const BufferedAVLTree &src) : root(copy(src.root)), combiner(src.combiner), inbox(src.inbox), capacity(src.capacity), size(src.size), tombstones(src.tombstones), pending(src.pending){};
+
+     BufferedAVLTree(BufferedAVLTree &&src) : root(src.root), combiner(std::move(src.combiner)), inbox(std::move(src.inbox)), capacity(src.capacity), size(src.size), tombstones(src.tombstones), pending(src.pending)
+     {
+          src.root = nullptr;
+          src.combiner.resize(combiner.size());
+          src.inbox.clear();
+          src.size = src.tombstones = 0;
+          src.pending = 0;
+     };
+
+     BufferedAVLTree &operator=(const BufferedAVLTree &src)
+     {
+          if (this != &src)
+          {
+               BufferedAVLTree copy(src);
+               swap(copy);
+          }
+          return *this;
+     }
+
+     BufferedAVLTree &operator=(BufferedAVLTree &&src)
+     {
+          if (this != &src)
+          {
+               clear();
+               swap(src);
+          }
+          return *this;
+     }
+
+     void swap(BufferedAVLTree &other)
+     {
+          std::swap(root, other.root);
+          std::swap(combiner, other.combiner);
+          std::swap(inbox, other.inbox);
+          std::swap(capacity, other.capacity);
+          std::swap(size, other.size);
+          std::swap(tombstones, other.tombstones);
+          std::swap(pending, other.pending);
+     }
+
+     ~BufferedAVLTree()
+     {
+          clear();
+     }
+
+     // stops at the first live element
+     bool empty() const
+     {
+          if (pending == 0)
+               return size == tombstones;
+          bool found = false;
+          for_each_element([&found](const Key &, const Info &)
+                           {
+                                found = true;
+                                return false; });
+          return !found;
+     }
+
+     bool exists(const Key &key) const
+     {
+          Info info{};
+          return lookup(key, info);
+     }
+
+     // queue an insertion; an existing key keeps its info
+     void insert(const Key &key, const Info &info)
+     {
+          post(Insert, key, info);
+     }
+
+     // queue an increment of the key's info by delta, inserting delta if the key is absent
+     void increment(const Key &key, const Info &delta)
+     {
+          post(Add, key, delta);
+     }
+
+     // queue a removal
+     void remove(const Key &key)
+     {
+          post(Remove, key, Info{});
+     }
+
+     // the pending messages for key are applied first, so the reference stays valid
+     Info &find(const Key &key)
+     {
+          Info *info = try_find(key);
+          if (info)
+               return *info;
+          throw "Element with given key does not exist!";
+     }
+
+     // like find, but a missing key gives nullptr instead of an exception
+     Info *try_find(const Key &key)
+     {
+          Node *node = resolve(key);
+          if (node)
+               return &node->info;
+          return nullptr;
+     }
+
+     // the info of key, or fallback when key is missing
+     Info find_or(const Key &key, const Info &fallback)
+     {
+          Info *info = try_find(key);
+          return info ? *info : fallback;
+     }
+
+     Info &operator[](const Key &key)
+     {
+          return find(key);
+     }
+
+     // O(1) when no message is pending, e.g. after flush or compact; otherwise the
+     // pending messages are merged with the nodes, since whether a message adds or
+     // removes an element is only known against the node it ends up at
+     int count() const
+     {
+          if (pending == 0)
+               return size - tombstones;
+          int live = 0;
+          for_each_element([&live](const Key &, const Info &)
+                           {
+                                live++;
+                                return true; });
+          return live;
+     }
+
+     int height() const
+     {
+          return height(root);
+     }
+
+     void clear()
+     {
+          clear(root);
+          root = nullptr;
+          for (auto &slot : combiner)
+               slot.reset();
+          inbox.clear();
+          size = tombstones = 0;
+          pending = 0;
+     }
+
+     // apply every pending message
+     void flush()
+     {
+          drain();
+          root = flush_all(root);
+     }
+
+     // apply every pending message, drop the tombstones and rebuild a balanced tree
+     void compact()
+     {
+          flush();
+          std::vector<Node *> nodes;
+          flatten(root, nodes);
+          root = build(nodes, 0, nodes.size());
+          size = nodes.size();
+          tombstones = 0;
+     }
+
+     // same format as AVLTree::print_inorder
+     void print_inorder() const
+     {
+          OutputBuffer out;
+          for_each_element([&out](const Key &key, const Info &info)
+                           {
+                                out.put('(').put(key).put(", ").put(info).put("),  ");
+                                return true; });
+     }
+
+     std::vector<std::pair<Key, Info>> get_elements() const
+     {
+          std::vector<std::pair<Key, Info>> elements;
+          for_each_element([&elements](const Key &key, const Info &info)
+                           {
+                                elements.emplace_back(key, info);
+                                return true; });
+          return elements;
+     }
+};
@@ -0,0 +1,359 @@
+#pragma once
+#include "avl.hpp"
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+// crash-safe checkpoints of a word count: a binary snapshot of the whole dictionary
+// in path and an append-only log of the counts added since then in path + ".log";
+// both carry the generation of the snapshot, so a log that outlived its snapshot is
+// ignored, and recovery replays at most what was logged since the last snapshot
+//
+// snapshot: magic, generation, position, words, then per word length, bytes and count,
+//           then a checksum of all of it
+// log:      magic, generation, then batches of entries, position, per entry length,
+//           bytes and delta, then a checksum of the batch
+class CountCheckpoint
+{
+     static const std::uint64_t SnapshotMagic = 0x544e554f43564153; // "SAVCOUNT"
+     static const std::uint64_t LogMagic = 0x474f4c544e554f43;      // "COUNTLOG"
+
+     std::string path;
+     std::uint64_t gen;               // generation of the current snapshot
+     std::uint64_t offset;            // input position covered by what is on disk
+     int log;                         // log descriptor, -1 until recover or snapshot
+     AVLTree<std::string, int> deltas; // counts recorded since the last sync
+
+     static void fail(const std::string &what)
+     {
+          throw std::runtime_error("CountCheckpoint: " + what + ": " + std::strerror(errno));
+     }
+
+     // FNV-1a
+     static std::uint64_t checksum(const char *data, std::size_t size)
+     {
+          std::uint64_t h = 0xcbf29ce484222325;
+          for (std::size_t i = 0; i < size; i++)
+               h = (h ^ static_cast<unsigned char>(data[i])) * 0x100000001b3;
+          return h;
+     }
+
+     template <typename T>
+     static void put(std::string &out, T value)
+     {
+          out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+     }
+
+     static void put(std::string &out, const std::string &word, int count)
+     {
+          put(out, std::uint32_t(word.size()));
+          out += word;
+          put(out, std::int32_t(count));
+     }
+
+     // reads fixed-size values and words off a buffer; fails once it runs out
+     struct Reader
+     {
+          const std::string &in;
+          std::size_t at;
+          bool ok;
+
+          template <typename T>
+          T get()
+          {
+               T value{};
+               if (at + sizeof(value) > in.size())
+                    ok = false;
+               else
+                    std::memcpy(&value, &in[at], sizeof(value));
+               at += sizeof(value);
+               return value;
+          }
+
+          std::string word()
+          {
+               std::uint32_t length = get<std::uint32_t>();
+               if (!ok or at + length > in.size())
+               {
+                    ok = false;
+                    return std::string();
+               }
+               at += length;
+               return in.substr(at - length, length);
+          }
+     };
+
+     static bool read_file(const std::string &name, std::string &out)
+     {
+          int fd = open(name.c_str(), O_RDONLY);
+          if (fd < 0)
+          {
+               if (errno == ENOENT)
+                    return false;
+               fail("cannot open " + name);
+          }
+          char buffer[65536];
+          ssize_t n;
+          out.clear();
+          while ((n = read(fd, buffer, sizeof(buffer))) != 0)
+          {
+               if (n < 0 and errno == EINTR)
+                    continue;
+               if (n < 0)
+               {
+                    close(fd);
+                    fail("cannot read " + name);
+               }
+               out.append(buffer, n);
+          }
+          close(fd);
+          return true;
+     }
+
+     static void write_all(int fd, const std::string &data)
+     {
+          std::size_t done = 0;
+          while (done < data.size())
+          {
+               ssize_t n = write(fd, data.data() + done, data.size() - done);
+               if (n < 0 and errno == EINTR)
+                    continue;
+               if (n < 0)
+                    fail("write failed");
+               done += n;
+          }
+     }
+
+     // replace name by data in one step: write a temporary file, sync it, rename it
+     // over name and sync the directory that holds the new entry
+     static void replace_file(const std::string &name, const std::string &data)
+     {
+          std::string temp = name + ".tmp";
+          int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+          if (fd < 0)
+               fail("cannot create " + temp);
+          write_all(fd, data);
+          if (fsync(fd) < 0)
+               fail("cannot sync " + temp);
+          close(fd);
+          if (std::rename(temp.c_str(), name.c_str()) < 0)
+               fail("cannot rename " + temp);
+          std::size_t slash = name.rfind('/');
+          std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : name.substr(0, slash);
+          int dir = open(directory.c_str(), O_RDONLY);
+          if (dir >= 0)
+          {
+               fsync(dir);
+               close(dir);
+          }
+     }
+
+     // start an empty log for the current generation
+     void reset_log()
+     {
+          if (log >= 0)
+               close(log);
+          std::string header;
+          put(header, LogMagic);
+          put(header, gen);
+          replace_file(path + ".log", header);
+          open_log();
+     }
+
+     void open_log()
+     {
+          log = open((path + ".log").c_str(), O_WRONLY | O_APPEND);
+          if (log < 0)
+               fail("cannot open " + path + ".log");
+     }
+
+public:
+     explicit CountCheckpoint(const std::string &path) : path(path), gen(0), offset(0), log(-1){};
+
+     CountCheckpoint(const CountCheckpoint &) = delete;
+
+     CountCheckpoint &operator=(const CountCheckpoint &) = delete;
+
+     // counts recorded after the last sync are lost, as they would be in a crash
+     ~CountCheckpoint()
+     {
+          if (log >= 0)
+               close(log);
+     }
+
+     // load the last snapshot into dict and replay the log on top of it; a torn batch
+     // at the end of the log, left by a crash during sync, is dropped; returns the
+     // number of batches replayed
+     std::size_t recover(AVLTree<std::string, int> &dict)
+     {
+          dict.clear();
+          deltas.clear();
+          gen = offset = 0;
+          std::string data;
+          if (read_file(path, data))
+          {
+               Reader in{data, 0, true};
+               std::uint64_t magic = in.get<std::uint64_t>();
+               gen = in.get<std::uint64_t>();
+               offset = in.get<std::uint64_t>();
+               std::uint64_t words = in.get<std::uint64_t>();
+               for (std::uint64_t i = 0; i < words and in.ok; i++)
+               {
+                    std::string word = in.word();
+                    int count = in.get<std::int32_t>();
+                    if (in.ok)
+                         dict.insert(word, count);
+               }
+               std::size_t end = in.at;
+               if (!(magic == SnapshotMagic and in.ok and in.get<std::uint64_t>() == checksum(data.data(), end) and in.ok))
+                    throw std::runtime_error("CountCheckpoint: " + path + " is not a valid snapshot");
+          }
+
+          std::size_t batches = 0;
+          if (!read_file(path + ".log", data))
+          {
+               reset_log();
+               return batches;
+          }
+          Reader in{data, 0, true};
+          if (!(in.get<std::uint64_t>() == LogMagic and in.get<std::uint64_t>() == gen and in.ok))
+          {
+               // the snapshot was replaced after this log was written
+               reset_log();
+               return batches;
+          }
+          std::size_t good = in.at; // end of the last complete batch
+          while (in.ok and in.at < data.size())
+          {
+               std::size_t start = in.at;
+               std::uint32_t entries = in.get<std::uint32_t>();
+               std::uint64_t position = in.get<std::uint64_t>();
+               std::vector<std::pair<std::string, int>> batch;
+               for (std::uint32_t i = 0; i < entries and in.ok; i++)
+               {
+                    std::string word = in.word();
+                    int delta = in.get<std::int32_t>();
+                    batch.emplace_back(word, delta);
+               }
+               std::size_t end = in.at;
+               if (!(in.ok and in.get<std::uint64_t>() == checksum(&data[start], end - start) and in.ok))
+                    break;
+               for (auto &ele : batch)
+               {
+                    int *count = dict.try_find(ele.first);
+                    if (count)
+                         *count += ele.second;
+                    else
+                         dict.insert(ele.first, ele.second);
+               }
+               offset = position;
+               good = in.at;
+               batches++;
+          }
+          open_log();
+          if (good < data.size() and ftruncate(log, good) < 0)
+               fail("cannot truncate " + path + ".log");
+          return batches;
+     }
+
+     // add delta to the count of word; kept in memory until the next sync
+     void record(const std::string &word, int delta = 1)
+     {
+          int *count = deltas.try_find(word);
+          if (count)
+               *count += delta;
+          else
+               deltas.insert(word, delta);
+     }
+
+     // append the recorded counts to the log as one batch and make it durable;
+     // position is how far into the input they reach
+     void sync(std::uint64_t position)
+     {
+          write_batch(take_batch(position), position);
+     }
+
+     // first half of sync: encode the recorded counts as a batch and forget them;
+     // a caller that shares record with other threads holds its lock for this half
+     // only, and writes the batch without it
+     std::string take_batch(std::uint64_t position)
+     {
+          std::string batch;
+          if (deltas.count() == 0 and position == offset)
+               return batch;
+          put(batch, std::uint32_t(deltas.count()));
+          put(batch, position);
+          for (auto &ele : deltas.get_elements())
+               put(batch, ele.first, ele.second);
+          put(batch, checksum(batch.data(), batch.size()));
+          deltas.clear();
+          return batch;
+     }
+
+     // second half of sync: append the batch to the log and make it durable
+     void write_batch(const std::string &batch, std::uint64_t position)
+     {
+          if (log < 0)
+               reset_log();
+          if (batch.empty())
+               return;
+          write_all(log, batch);
+          if (fdatasync(log) < 0)
+               fail("cannot sync " + path + ".log");
+          offset = position;
+     }
+
+     // replace the snapshot by dict, which must already hold all recorded counts,
+     // and start a new, empty log
+     void snapshot(const AVLTree<std::string, int> &dict, std::uint64_t position)
+     {
+          write_snapshot(take_snapshot(dict), position);
+     }
+
+     // first half of snapshot, like take_batch: copy the counts of dict and forget
+     // the recorded ones, which it holds
+     std::vector<std::pair<std::string, int>> take_snapshot(const AVLTree<std::string, int> &dict)
+     {
+          deltas.clear();
+          return dict.get_elements();
+     }
+
+     // second half of snapshot: write the copied counts and start a new, empty log;
+     // counts recorded since take_snapshot go to that log with the next sync
+     void write_snapshot(const std::vector<std::pair<std::string, int>> &elements, std::uint64_t position)
+     {
+          std::string data;
+          put(data, SnapshotMagic);
+          put(data, gen + 1);
+          put(data, position);
+          put(data, std::uint64_t(elements.size()));
+          for (auto &ele : elements)
+               put(data, ele.first, ele.second);
+          put(data, checksum(data.data(), data.size()));
+          // a crash between the two replacements leaves a log of the old generation,
+          // whose counts are all in the new snapshot
+          replace_file(path, data);
+          gen++;
+          offset = position;
+          reset_log();
+     }
+
+     // number of snapshots taken
+     std::uint64_t generation() const
+     {
+          return gen;
+     }
+
+     // input position covered by the snapshot and the synced log; a restarted job
+     // resumes reading its input from here
+     std::uint64_t position() const
+     {
+          return offset;
+     }
+};
@@ -0,0 +1,686 @@
+#pragma once
+#include "epoch.hpp"
+#include <iostream>
+#include <vector>
+#include <optional>
+#include <algorithm>
+
+// AVL tree for many concurrent writers (Bronson et al., "A Practical Concurrent
+// Binary Search Tree"): searches run without locks and validate per-node versions
+// hand over hand, updates lock only the nodes they change, removed keys leave
+// routing nodes behind, and balance is repaired afterwards by local rotations
+template <typename Key, typename Info>
+class ConcurrentAVLTree
+{
+     static const std::uint64_t Unlinked = 1;  // version of a node removed from the tree
+     static const std::uint64_t Shrinking = 2; // set while a rotation moves the node down
+     static const std::uint64_t Step = 4;      // version increment after each shrink
+
+     static const int UnlinkRequired = -1, RebalanceRequired = -2, NothingRequired = -3;
+
+     enum Result
+     {
+          Retry,
+          Absent,
+          Present
+     };
+
+     class Lock
+     { // spinlock held only for a few pointer updates
+          std::atomic<bool> held{false};
+
+     public:
+          void lock()
+          {
+               while (held.exchange(true, std::memory_order_acquire))
+                    while (held.load(std::memory_order_relaxed))
+                         std::this_thread::yield();
+          }
+          void unlock()
+          {
+               held.store(false, std::memory_order_release);
+          }
+     };
+
+     struct Node
+     { // node structure
+          const Key key;
+          std::atomic<std::uint64_t> version; // changes whenever the range of keys below the node shrinks
+          std::atomic<const Info *> info;     // nullptr for a routing node
+          std::atomic<int> height;            // 1 for a leaf
+          std::atomic<Node *> parent, left, right;
+          Lock lock;
+          Node(const Key &key, const Info *info, Node *parent) : key(key), version(0), info(info), height(1), parent(parent), left(nullptr), right(nullptr){};
+          Node *child(int dir) const
+          {
+               return dir < 0 ? left.load() : right.load();
+          }
+     };
+
+     Node *holder;                // sentinel whose right child is the root
+     std::atomic<int> size;       // number of keys
+     std::atomic<unsigned> writes; // updates since construction, drives reclamation
+     mutable EpochManager epochs; // unlinked nodes and replaced infos
+
+     static void dispose_node(void *node)
+     {
+          delete static_cast<Node *>(node);
+     }
+
+     static void dispose_info(void *info)
+     {
+          delete static_cast<const Info *>(info);
+     }
+
+     static int compare(const Key &key, const Node *node)
+     {
+          if (key < node->key)
+               return -1;
+          if (key > node->key)
+               return 1;
+          return 0;
+     }
+
+     static int height(const Node *node)
+     {
+          if (node)
+               return node->height.load();
+          return 0;
+     }
+
+     // wait for the rotation that is moving the node down
+     static void wait(Node *node, std::uint64_t version)
+     {
+          for (int i = 0; i < 100; i++)
+               if (node->version.load() != version)
+                    return;
+          for (int i = 0; i < 100; i++)
+          {
+               std::this_thread::yield();
+               if (node->version.load() != version)
+                    return;
+          }
+          std::lock_guard<Lock> guard(node->lock);
+     }
+
+     // searches descend from node towards dir; node_version is the version node had when
+     // its key range was known to contain the key, and any change means start over higher up
+
+     Result attempt_get(const Key &key, Node *node, int dir, std::uint64_t node_version, Info &info) const
+     {
+          while (true)
+          {
+               Node *child = node->child(dir);
+               if (node->version.load() != node_version)
+                    return Retry;
+               if (child == nullptr)
+                    return Absent;
+               int next = compare(key, child);
+               if (next == 0)
+               {
+                    const Info *found = child->info.load();
+                    if (found == nullptr)
+                         return Absent;
+                    info = *found;
+                    return Present;
+               }
+               std::uint64_t child_version = child->version.load();
+               if (child_version & Shrinking)
+                    wait(child, child_version);
+               else if (child_version != Unlinked and child == node->child(dir))
+               {
+                    if (node->version.load() != node_version)
+                         return Retry;
+                    Result result = attempt_get(key, child, next, child_version, info);
+                    if (result != Retry)
+                         return result;
+               }
+          }
+     }
+
+     Result attempt_put(const Key &key, const Info &info, bool overwrite, Node *node, int dir, std::uint64_t node_version)
+     {
+          Result result = Retry;
+          do
+          {
+               Node *child = node->child(dir);
+               if (node->version.load() != node_version)
+                    return Retry;
+               if (child == nullptr)
+                    result = attempt_insert(key, info, node, dir, node_version);
+               else
+               {
+                    int next = compare(key, child);
+                    if (next == 0)
+                         result = attempt_update(child, info, overwrite);
+                    else
+                    {
+                         std::uint64_t child_version = child->version.load();
+                         if (child_version & Shrinking)
+                              wait(child, child_version);
+                         else if (child_version != Unlinked and child == node->child(dir))
+                         {
+                              if (node->version.load() != node_version)
+                                   return Retry;
+                              result = attempt_put(key, info, overwrite, child, next, child_version);
+                         }
+                    }
+               }
+          } while (result == Retry);
+          return result;
+     }
+
+     Result attempt_insert(const Key &key, const Info &info, Node *node, int dir, std::uint64_t node_version)
+     {
+          {
+               std::lock_guard<Lock> guard(node->lock);
+               if (node->version.load() != node_version or node->child(dir) != nullptr)
+                    return Retry;
+               (dir < 0 ? node->left : node->right).store(new Node(key, new Info(info), node));
+          }
+          fix_height_and_rebalance(node);
+          return Absent;
+     }
+
+     // set the info of a node that holds the key, reviving it if it is a routing node
+     Result attempt_update(Node *node, const Info &info, bool overwrite)
+     {
+          std::lock_guard<Lock> guard(node->lock);
+          if (node->version.load() == Unlinked)
+               return Retry;
+          const Info *old = node->info.load();
+          if (old != nullptr and !overwrite)
+               return Present;
+          node->info.store(new Info(info));
+          if (old == nullptr)
+               return Absent;
+          epochs.retire(const_cast<Info *>(old), dispose_info);
+          return Present;
+     }
+
+     Result attempt_remove(const Key &key, Node *node, int dir, std::uint64_t node_version)
+     {
+          Result result = Retry;
+          do
+          {
+               Node *child = node->child(dir);
+               if (node->version.load() != node_version)
+                    return Retry;
+               if (child == nullptr)
+                    return Absent;
+               int next = compare(key, child);
+               if (next == 0)
+                    result = attempt_remove_node(node, child);
+               else
+               {
+                    std::uint64_t child_version = child->version.load();
+                    if (child_version & Shrinking)
+                         wait(child, child_version);
+                    else if (child_version != Unlinked and child == node->child(dir))
+                    {
+                         if (node->version.load() != node_version)
+                              return Retry;
+                         result = attempt_remove(key, child, next, child_version);
+                    }
+               }
+          } while (result == Retry);
+          return result;
+     }
+
+     // a node with two children becomes a routing node, otherwise it is spliced out
+     Result attempt_remove_node(Node *parent, Node *node)
+     {
+          if (node->info.load() == nullptr)
+               return Absent;
+          const Info *old;
+          if (node->left.load() != nullptr and node->right.load() != nullptr)
+          {
+               std::lock_guard<Lock> guard(node->lock);
+               if (node->version.load() == Unlinked or node->left.load() == nullptr or node->right.load() == nullptr)
+                    return Retry;
+               old = node->info.exchange(nullptr);
+               if (old == nullptr)
+                    return Absent;
+          }
+          else
+          {
+               {
+                    std::lock_guard<Lock> parent_guard(parent->lock);
+                    if (parent->version.load() == Unlinked or node->parent.load() != parent)
+                         return Retry;
+                    std::lock_guard<Lock> guard(node->lock);
+                    if (node->version.load() == Unlinked)
+                         return Retry;
+                    old = node->info.load();
+                    if (old == nullptr)
+                         return Absent;
+                    if (!unlink(parent, node))
+                         return Retry;
+               }
+               fix_height_and_rebalance(parent);
+          }
+          epochs.retire(const_cast<Info *>(old), dispose_info);
+          return Present;
+     }
+
+     // splice out a node with at most one child; both nodes are locked
+     bool unlink(Node *parent, Node *node)
+     {
+          Node *parent_left = parent->left.load();
+          if (parent_left != node and parent->right.load() != node)
+               return false;
+          Node *left = node->left.load(), *right = node->right.load();
+          if (left != nullptr and right != nullptr)
+               return false;
+          Node *splice = left ? left : right;
+          (parent_left == node ? parent->left : parent->right).store(splice);
+          if (splice)
+               splice->parent.store(parent);
+          node->version.store(Unlinked);
+          node->info.store(nullptr);
+          epochs.retire(node, dispose_node);
+          return true;
+     }
+
+     // what the node needs: unlinking, a rotation, a new height or nothing
+     int condition(Node *node)
+     {
+          Node *left = node->left.load(), *right = node->right.load();
+          if ((left == nullptr or right == nullptr) and node->info.load() == nullptr)
+               return UnlinkRequired;
+          int h = node->height.load(), hl = height(left), hr = height(right);
+          int repl = 1 + std::max(hl, hr);
+          if (hl - hr < -1 or hl - hr > 1)
+               return RebalanceRequired;
+          return h != repl ? repl : NothingRequired;
+     }
+
+     // walk up from a changed node, repairing each damaged node under local locks
+     void fix_height_and_rebalance(Node *node)
+     {
+          while (node != nullptr and node->parent.load() != nullptr)
+          {
+               int c = condition(node);
+               if (c == NothingRequired or node->version.load() == Unlinked)
+                    return;
+               if (c != UnlinkRequired and c != RebalanceRequired)
+               {
+                    std::lock_guard<Lock> guard(node->lock);
+                    node = fix_height(node);
+               }
+               else
+               {
+                    Node *parent = node->parent.load();
+                    std::lock_guard<Lock> parent_guard(parent->lock);
+                    if (parent->version.load() != Unlinked and node->parent.load() == parent)
+                    {
+                         std::lock_guard<Lock> guard(node->lock);
+                         node = rebalance(parent, node);
+                    }
+               }
+          }
+     }
+
+     // the following return the next node that may need repair, nullptr when done
+
+     Node *fix_height(Node *node)
+     {
+          int c = condition(node);
+          switch (c)
+          {
+          case RebalanceRequired:
+          case UnlinkRequired:
+               return node;
+          case NothingRequired:
+               return nullptr;
+          default:
+               node->height.store(c);
+               return node->parent.load();
+          }
+     }
+
+     Node *rebalance(Node *parent, Node *node)
+     {
+          Node *left = node->left.load(), *right = node->right.load();
+          if ((left == nullptr or right == nullptr) and node->info.load() == nullptr)
+          {
+               if (unlink(parent, node))
+                    return fix_height(parent);
+               return node;
+          }
+          int h = node->height.load(), hl = height(left), hr = height(right);
+          int repl = 1 + std::max(hl, hr);
+          if (hl - hr > 1)
+               return rebalance_to_right(parent, node, left, hr);
+          if (hl - hr < -1)
+               return rebalance_to_left(parent, node, right, hl);
+          if (repl != h)
+          {
+               node->height.store(repl);
+               return fix_height(parent);
+          }
+          return nullptr;
+     }
+
+     Node *rebalance_to_right(Node *parent, Node *node, Node *left, int hr)
+     {
+          std::lock_guard<Lock> guard(left->lock);
+          if (left->height.load() - hr <= 1)
+               return node;
+          Node *lr = left->right.load();
+          int hll = height(left->left.load()), hlr = height(lr);
+          if (hll >= hlr)
+               return rotate_right(parent, node, left, hr, hll, lr, hlr);
+          {
+               std::lock_guard<Lock> lr_guard(lr->lock);
+               hlr = lr->height.load();
+               if (hll >= hlr)
+                    return rotate_right(parent, node, left, hr, hll, lr, hlr);
+               int hlrl = height(lr->left.load());
+               if (hll - hlrl >= -1 and hll - hlrl <= 1 and !((hll == 0 or hlrl == 0) and left->info.load() == nullptr))
+                    return rotate_right_over_left(parent, node, left, hr, hll, lr, hlrl);
+          }
+          // a double rotation would leave left damaged, so repair it first
+          return rebalance_to_left(node, left, lr, hll);
+     }
+
+     Node *rebalance_to_left(Node *parent, Node *node, Node *right, int hl)
+     {
+          std::lock_guard<Lock> guard(right->lock);
+          if (hl - right->height.load() >= -1)
+               return node;
+          Node *rl = right->left.load();
+          int hrl = height(rl), hrr = height(right->right.load());
+          if (hrr >= hrl)
+               return rotate_left(parent, node, hl, right, rl, hrl, hrr);
+          {
+               std::lock_guard<Lock> rl_guard(rl->lock);
+               hrl = rl->height.load();
+               if (hrr >= hrl)
+                    return rotate_left(parent, node, hl, right, rl, hrl, hrr);
+               int hrlr = height(rl->right.load());
+               if (hrr - hrlr >= -1 and hrr - hrlr <= 1 and !((hrr == 0 or hrlr == 0) and right->info.load() == nullptr))
+                    return rotate_left_over_right(parent, node, hl, right, rl, hrr, hrlr);
+          }
+          return rebalance_to_right(node, right, rl, hrr);
+     }
+
+     // rotations run with parent, node and the nodes moving up locked; a node moving
+     // down is marked shrinking so that searches passing through it wait and retry
+
+     void replace_child(Node *parent, Node *node, Node *child)
+     {
+          (parent->left.load() == node ? parent->left : parent->right).store(child);
+          child->parent.store(parent);
+     }
+
+     Node *rotate_right(Node *parent, Node *node, Node *left, int hr, int hll, Node *lr, int hlr)
+     {
+          std::uint64_t version = node->version.load();
+          node->version.store(version | Shrinking);
+          node->left.store(lr);
+          if (lr)
+               lr->parent.store(node);
+          left->right.store(node);
+          node->parent.store(left);
+          replace_child(parent, node, left);
+          int hn = 1 + std::max(hlr, hr);
+          node->height.store(hn);
+          left->height.store(1 + std::max(hll, hn));
+          node->version.store(version + Step);
+
+          if (hlr - hr < -1 or hlr - hr > 1)
+               return node;
+          if ((lr == nullptr or hr == 0) and node->info.load() == nullptr)
+               return node;
+          if (hll - hn < -1 or hll - hn > 1)
+               return left;
+          if (hll == 0 and left->info.load() == nullptr)
+               return left;
+          return fix_height(parent);
+     }
+
+     Node *rotate_left(Node *parent, Node *node, int hl, Node *right, Node *rl, int hrl, int hrr)
+     {
+          std::uint64_t version = node->version.load();
+          node->version.store(version | Shrinking);
+          node->right.store(rl);
+          if (rl)
+               rl->parent.store(node);
+          right->left.store(node);
+          node->parent.store(right);
+          replace_child(parent, node, right);
+          int hn = 1 + std::max(hl, hrl);
+          node->height.store(hn);
+          right->height.store(1 + std::max(hn, hrr));
+          node->version.store(version + Step);
+
+          if (hrl - hl < -1 or hrl - hl > 1)
+               return node;
+          if ((rl == nullptr or hl == 0) and node->info.load() == nullptr)
+               return node;
+          if (hrr - hn < -1 or hrr - hn > 1)
+               return right;
+          if (hrr == 0 and right->info.load() == nullptr)
+               return right;
+          return fix_height(parent);
+     }
+
+     Node *rotate_right_over_left(Node *parent, Node *node, Node *left, int hr, int hll, Node *lr, int hlrl)
+     {
+          std::uint64_t version = node->version.load(), left_version = left->version.load();
+          Node *lrl = lr->left.load(), *lrr = lr->right.load();
+          int hlrr = height(lrr);
+          node->version.store(version | Shrinking);
+          left->version.store(left_version | Shrinking);
+          node->left.store(lrr);
+          if (lrr)
+               lrr->parent.store(node);
+          left->right.store(lrl);
+          if (lrl)
+               lrl->parent.store(left);
+          lr->left.store(left);
+          left->parent.store(lr);
+          lr->right.store(node);
+          node->parent.store(lr);
+          replace_child(parent, node, lr);
+          int hn = 1 + std::max(hlrr, hr), hl = 1 + std::max(hll, hlrl);
+          node->height.store(hn);
+          left->height.store(hl);
+          lr->height.store(1 + std::max(hl, hn));
+          node->version.store(version + Step);
+          left->version.store(left_version + Step);
+
+          if (hlrr - hr < -1 or hlrr - hr > 1)
+               return node;
+          if ((lrr == nullptr or hr == 0) and node->info.load() == nullptr)
+               return node;
+          if (hl - hn < -1 or hl - hn > 1)
+               return lr;
+          return fix_height(parent);
+     }
+
+     Node *rotate_left_over_right(Node *parent, Node *node, int hl, Node *right, Node *rl, int hrr, int hrlr)
+     {
+          std::uint64_t version = node->version.load(), right_version = right->version.load();
+          Node *rll = rl->left.load(), *rlr = rl->right.load();
+          int hrll = height(rll);
+          node->version.store(version | Shrinking);
+          right->version.store(right_version | Shrinking);
+          node->right.store(rll);
+          if (rll)
+               rll->parent.store(node);
+          right->left.store(rlr);
+          if (rlr)
+               rlr->parent.store(right);
+          rl->right.store(right);
+          right->parent.store(rl);
+          rl->left.store(node);
+          node->parent.store(rl);
+          replace_child(parent, node, rl);
+          int hn = 1 + std::max(hl, hrll), hr = 1 + std::max(hrlr, hrr);
+          node->height.store(hn);
+          right->height.store(hr);
+          rl->height.store(1 + std::max(hn, hr));
+          node->version.store(version + Step);
+          right->version.store(right_version + Step);
+
+          if (hrll - hl < -1 or hrll - hl > 1)
+               return node;
+          if ((rll == nullptr or hl == 0) and node->info.load() == nullptr)
+               return node;
+          if (hr - hn < -1 or hr - hn > 1)
+               return rl;
+          return fix_height(parent);
+     }
+
+     // free what the updates of the last while have unlinked
+     void collect_garbage()
+     {
+          if (writes.fetch_add(1, std::memory_order_relaxed) % 256 == 255)
+               epochs.reclaim();
+     }
+
+     void destroy(Node *node)
+     {
+          if (node)
+          {
+               destroy(node->left.load());
+               destroy(node->right.load());
+               delete node->info.load();
+               delete node;
+          }
+     }
+
+     void get_elements(std::vector<std::pair<Key, Info>> &elements, const Node *node) const
+     {
+          if (node)
+          {
+               get_elements(elements, node->left.load());
+               const Info *info = node->info.load();
+               if (info)
+                    elements.emplace_back(node->key, *info);
+               get_elements(elements, node->right.load());
+          }
+     }
+
+public:
+     ConcurrentAVLTree() : holder(new Node(Key(), nullptr, nullptr)), size(0), writes(0){};
+
+     ConcurrentAVLTree(const ConcurrentAVLTree &) = delete;
+
+     ConcurrentAVLTree &operator=(const ConcurrentAVLTree &) = delete;
+
+     // no other thread may be left when the tree is destroyed
+     ~ConcurrentAVLTree()
+     {
+          destroy(holder);
+     }
+
+     bool empty() const
+     {
+          return count() == 0;
+     }
+
+     int count() const
+     {
+          return size.load();
+     }
+
+     // height of the tree, routing nodes included
+     int height() const
+     {
+          EpochManager::Guard guard(epochs);
+          return height(holder->right.load()) - 1;
+     }
+
+     bool exists(const Key &key) const
+     {
+          Info info;
+          EpochManager::Guard guard(epochs);
+          return attempt_get(key, holder, 1, 0, info) == Present;
+     }
+
+     // returns a copy, since the info may be replaced as soon as the reader leaves
+     Info find(const Key &key) const
+     {
+          std::optional<Info> info = try_find(key);
+          if (info)
+               return *info;
+          throw "Element with given key does not exist!";
+     }
+
+     // like find, but a missing key gives an empty optional instead of an exception
+     std::optional<Info> try_find(const Key &key) const
+     {
+          Info info;
+          EpochManager::Guard guard(epochs);
+          if (attempt_get(key, holder, 1, 0, info) == Present)
+               return info;
+          return std::nullopt;
+     }
+
+     // the info of key, or fallback when key is missing
+     Info find_or(const Key &key, const Info &fallback) const
+     {
+          return try_find(key).value_or(fallback);
+     }
+
+     // insert only if the key is not in the tree yet
+     bool insert(const Key &key, const Info &info)
+     {
+          Result result;
+          {
+               EpochManager::Guard guard(epochs);
+               result = attempt_put(key, info, false, holder, 1, 0);
+          }
+          if (result == Absent)
+               size++;
+          collect_garbage();
+          return result == Absent;
+     }
+
+     // insert or replace the info; returns true if the key was new
+     bool assign(const Key &key, const Info &info)
+     {
+          Result result;
+          {
+               EpochManager::Guard guard(epochs);
+               result = attempt_put(key, info, true, holder, 1, 0);
+          }
+          if (result == Absent)
+               size++;
+          collect_garbage();
+          return result == Absent;
+     }
+
+     bool remove(const Key &key)
+     {
+          Result result;
+          {
+               EpochManager::Guard guard(epochs);
+               result = attempt_remove(key, holder, 1, 0);
+          }
+          if (result == Present)
+               size--;
+          collect_garbage();
+          return result == Present;
+     }
+
+     // in-order keys; exact when no update runs at the same time
+     std::vector<std::pair<Key, Info>> get_elements() const
+     {
+          EpochManager::Guard guard(epochs);
+          std::vector<std::pair<Key, Info>> elements;
+          get_elements(elements, holder->right.load());
+          return elements;
+     }
+
+     // no other thread may use the tree during clear
+     void clear()
+     {
+          destroy(holder->right.load());
+          holder->right.store(nullptr);
+          size.store(0);
+     }
+};
@@ -0,0 +1,142 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <cstdint>
+
+// epoch-based reclamation: readers announce the epoch they entered in, and memory
+// retired at some epoch is freed only when every announced epoch is later than that;
+// each thread retires into the list of the slot its id hashes to, so writers on
+// different threads do not contend for one lock
+class EpochManager
+{
+     static const std::size_t Slots = 128; // maximum number of concurrent readers
+
+     struct Retired
+     { // unlinked memory waiting for the readers that may still see it
+          std::uint64_t epoch;
+          void *ptr;
+          void (*dispose)(void *);
+     };
+
+     struct alignas(64) Slot
+     {
+          std::atomic<std::uint64_t> epoch{0}; // announced epoch of one reader, 0 when the slot is free
+          std::mutex lock;                     // guards retired
+          std::vector<Retired> retired;        // memory retired by the threads hashed to this slot
+     } slots[Slots];
+
+     std::atomic<std::uint64_t> global{1}; // current epoch
+
+     static std::size_t home()
+     {
+          return std::hash<std::thread::id>{}(std::this_thread::get_id()) % Slots;
+     }
+
+public:
+     // announces a reader for as long as it lives
+     class Guard
+     {
+          EpochManager &epochs;
+          std::size_t slot;
+
+     public:
+          Guard(EpochManager &epochs) : epochs(epochs), slot(epochs.enter()){};
+          Guard(const Guard &) = delete;
+          Guard &operator=(const Guard &) = delete;
+          ~Guard()
+          {
+               epochs.exit(slot);
+          }
+     };
+
+     EpochManager() = default;
+
+     EpochManager(const EpochManager &) = delete;
+
+     EpochManager &operator=(const EpochManager &) = delete;
+
+     // the owner must make sure no reader is left
+     ~EpochManager()
+     {
+          for (Slot &slot : slots)
+               for (Retired &r : slot.retired)
+                    r.dispose(r.ptr);
+     }
+
+     // claim a free slot and announce the current epoch in it
+     std::size_t enter()
+     {
+          std::size_t i = home();
+          while (true)
+          {
+               std::uint64_t idle = 0;
+               if (slots[i].epoch.compare_exchange_strong(idle, global.load()))
+               {
+                    // pairs with the fence in reclaim: either the writer sees this slot or
+                    // this reader sees everything published before the writer's scan
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    return i;
+               }
+               i = (i + 1) % Slots;
+          }
+     }
+
+     void exit(std::size_t slot)
+     {
+          slots[slot].epoch.store(0, std::memory_order_release);
+     }
+
+     // hand over memory that is no longer reachable from the shared structure
+     void retire(void *ptr, void (*dispose)(void *))
+     {
+          Slot &slot = slots[home()];
+          std::lock_guard<std::mutex> guard(slot.lock);
+          slot.retired.push_back({global.load(), ptr, dispose});
+     }
+
+     // start a new epoch and free what no reader can reach anymore
+     void reclaim()
+     {
+          // memory retired into the new epoch while the lists are swept stays for later,
+          // since a reader may have entered unseen before it was unlinked
+          std::uint64_t oldest = global.fetch_add(1) + 1;
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          for (Slot &slot : slots)
+          {
+               std::uint64_t epoch = slot.epoch.load();
+               if (epoch and epoch < oldest)
+                    oldest = epoch;
+          }
+          std::vector<Retired> ready;
+          for (Slot &slot : slots)
+          {
+               std::lock_guard<std::mutex> guard(slot.lock);
+               std::size_t kept = 0;
+               for (Retired &r : slot.retired)
+               {
+                    if (r.epoch < oldest)
+                         ready.push_back(r);
+                    else
+                         slot.retired[kept++] = r;
+               }
+               slot.retired.resize(kept);
+          }
+          for (Retired &r : ready)
+               r.dispose(r.ptr);
+     }
+
+     // number of retired allocations not freed yet
+     std::size_t pending()
+     {
+          std::size_t count = 0;
+          for (Slot &slot : slots)
+          {
+               std::lock_guard<std::mutex> guard(slot.lock);
+               count += slot.retired.size();
+          }
+          return count;
+     }
+};
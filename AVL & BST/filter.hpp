@@ -0,0 +1,130 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+// whether std::hash can hash Key
+template <typename Key, typename = void>
+struct is_hashable : std::false_type
+{
+};
+
+template <typename Key>
+struct is_hashable<Key, std::void_t<decltype(std::hash<Key>{}(std::declval<const Key &>()))>> : std::true_type
+{
+};
+
+// counting Bloom filter whose probes for a key all fall into one 64-byte block of 128
+// four-bit counters, so a query reads a single cache line; a counter that reaches 15
+// sticks there, which can only turn a later miss into a false positive
+template <typename Key, typename Hash = std::hash<Key>>
+class BlockedBloomFilter
+{
+     static const int Probes = 4;           // counters per key
+     static const int KeysPerBlock = 12;    // about 10 counters per key, ~1% false positives
+     static const std::uint64_t Max = 15;   // saturated counter
+
+     struct alignas(64) Block
+     {
+          std::uint64_t words[8]; // 16 counters each
+     };
+
+     std::vector<Block> blocks;
+     std::size_t items;
+     Hash hasher;
+
+     std::uint64_t hash(const Key &key) const
+     {
+          // splitmix64 finaliser, since std::hash of integers is the identity
+          std::uint64_t h = hasher(key) + 0x9e3779b97f4a7c15;
+          h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+          h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+          return h ^ (h >> 31);
+     }
+
+     Block &block(std::uint64_t h)
+     {
+          return blocks[(h >> 32) * blocks.size() >> 32];
+     }
+
+     const Block &block(std::uint64_t h) const
+     {
+          return blocks[(h >> 32) * blocks.size() >> 32];
+     }
+
+     // probe i selects one of the 128 counters of the block from the low hash bits
+     static std::uint64_t &word(Block &b, std::uint64_t h, int i, int &shift)
+     {
+          int counter = h >> (7 * i) & 127;
+          shift = counter % 16 * 4;
+          return b.words[counter / 16];
+     }
+
+public:
+     explicit BlockedBloomFilter(std::size_t capacity = 1024) : blocks(capacity / KeysPerBlock + 1, Block{}), items(0){};
+
+     void insert(const Key &key)
+     {
+          std::uint64_t h = hash(key);
+          Block &b = block(h);
+          for (int i = 0; i < Probes; i++)
+          {
+               int shift;
+               std::uint64_t &w = word(b, h, i, shift);
+               if ((w >> shift & Max) != Max)
+                    w += std::uint64_t(1) << shift;
+          }
+          items++;
+     }
+
+     // the key must have been inserted before
+     void remove(const Key &key)
+     {
+          std::uint64_t h = hash(key);
+          Block &b = block(h);
+          for (int i = 0; i < Probes; i++)
+          {
+               int shift;
+               std::uint64_t &w = word(b, h, i, shift);
+               std::uint64_t c = w >> shift & Max;
+               if (c != 0 and c != Max)
+                    w -= std::uint64_t(1) << shift;
+          }
+          items--;
+     }
+
+     // false means the key was definitely never inserted or has been removed
+     bool may_contain(const Key &key) const
+     {
+          std::uint64_t h = hash(key);
+          const Block &b = block(h);
+          bool all = true;
+          for (int i = 0; i < Probes; i++)
+          {
+               int counter = h >> (7 * i) & 127;
+               all &= (b.words[counter / 16] >> (counter % 16 * 4) & Max) != 0;
+          }
+          return all;
+     }
+
+     std::size_t count() const
+     {
+          return items;
+     }
+
+     // number of keys the filter was sized for
+     std::size_t capacity() const
+     {
+          return blocks.size() * KeysPerBlock;
+     }
+
+     void clear()
+     {
+          std::fill(blocks.begin(), blocks.end(), Block{});
+          items = 0;
+     }
+};
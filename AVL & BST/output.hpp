@@ -0,0 +1,252 @@
+#pragma once
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <unistd.h>
+
+// formats of exported elements, one element per line except for Binary
+enum class Format
+{
+     CSV,       // key,info with RFC 4180 quoting of strings
+     TSV,       // key<TAB>info
+     JSONLines, // {"key":...,"info":...}
+     Binary     // raw numbers and trivially copyable values, strings as a 32-bit length and bytes
+};
+
+// formats into one large reusable buffer and writes it to a file descriptor in big
+// chunks; numbers go through std::to_chars, other types fall back to operator<<
+class OutputBuffer
+{
+     int fd;
+     std::vector<char> buffer;
+     std::size_t used;
+
+     char *reserve(std::size_t bytes)
+     {
+          if (used + bytes > buffer.size())
+          {
+               flush();
+               if (bytes > buffer.size())
+                    buffer.resize(bytes);
+          }
+          return &buffer[used];
+     }
+
+     template <typename T>
+     static constexpr bool is_string()
+     {
+          return std::is_convertible<const T &, std::string_view>::value;
+     }
+
+     void quoted(std::string_view text, Format format)
+     {
+          if (format == Format::CSV)
+          {
+               if (text.find_first_of(",\"\r\n") == std::string_view::npos)
+               {
+                    put(text);
+                    return;
+               }
+               put('"');
+               for (char c : text)
+               {
+                    if (c == '"')
+                         put('"');
+                    put(c);
+               }
+               put('"');
+          }
+          else if (format == Format::TSV)
+          {
+               // tabs and newlines would split the fields
+               for (char c : text)
+                    put(c == '\t' ? "\\t" : c == '\n' ? "\\n" : c == '\\' ? "\\\\" : std::string_view(&c, 1));
+          }
+          else
+          {
+               static const char hex[] = "0123456789abcdef";
+               put('"');
+               for (char c : text)
+               {
+                    if (c == '"' or c == '\\')
+                    {
+                         put('\\');
+                         put(c);
+                    }
+                    else if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                         put("\\u00");
+                         put(hex[c >> 4]);
+                         put(hex[c & 15]);
+                    }
+                    else
+                         put(c);
+               }
+               put('"');
+          }
+     }
+
+     template <typename T>
+     void field(const T &value, Format format)
+     {
+          if constexpr (is_string<T>())
+               quoted(std::string_view(value), format);
+          else if constexpr (std::is_arithmetic<T>::value and !std::is_same<T, bool>::value)
+               put(value);
+          else if constexpr (std::is_same<T, bool>::value)
+               put(value ? "true" : "false");
+          else
+          {
+               std::ostringstream text;
+               text << value;
+               quoted(text.str(), format);
+          }
+     }
+
+     template <typename T>
+     void binary(const T &value)
+     {
+          if constexpr (is_string<T>())
+          {
+               std::string_view text(value);
+               std::uint32_t length = text.size();
+               raw(&length, sizeof(length));
+               raw(text.data(), text.size());
+          }
+          else
+          {
+               static_assert(std::is_trivially_copyable<T>::value, "Binary output needs strings or trivially copyable types");
+               raw(&value, sizeof(value));
+          }
+     }
+
+public:
+     // fd 1 is standard output
+     explicit OutputBuffer(int fd = 1, std::size_t capacity = 1 << 20) : fd(fd), buffer(capacity), used(0)
+     {
+          // keep the order of anything written through std::cout before
+          if (fd == 1)
+               std::cout.flush();
+     };
+
+     OutputBuffer(const OutputBuffer &) = delete;
+
+     OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+     ~OutputBuffer()
+     {
+          try
+          {
+               flush();
+          }
+          catch (const std::exception &e)
+          {
+               std::cerr << e.what() << "\n";
+          }
+     }
+
+     void flush()
+     {
+          std::size_t done = 0;
+          while (done < used)
+          {
+               ssize_t n = write(fd, buffer.data() + done, used - done);
+               if (n < 0 and errno == EINTR)
+                    continue;
+               if (n < 0)
+               {
+                    used = 0;
+                    throw std::runtime_error(std::string("OutputBuffer: write failed: ") + std::strerror(errno));
+               }
+               done += n;
+          }
+          used = 0;
+     }
+
+     OutputBuffer &put(char c)
+     {
+          *reserve(1) = c;
+          used++;
+          return *this;
+     }
+
+     OutputBuffer &put(std::string_view text)
+     {
+          return raw(text.data(), text.size());
+     }
+
+     OutputBuffer &put(const char *text)
+     {
+          return put(std::string_view(text));
+     }
+
+     OutputBuffer &put(const std::string &text)
+     {
+          return put(std::string_view(text));
+     }
+
+     template <typename T>
+     OutputBuffer &put(const T &value)
+     {
+          if constexpr (std::is_arithmetic<T>::value and !std::is_same<T, bool>::value and !std::is_same<T, char>::value)
+          {
+               // enough for any integer or shortest round-trip double
+               char *at = reserve(32);
+               used = std::to_chars(at, at + 32, value).ptr - buffer.data();
+          }
+          else if constexpr (is_string<T>())
+               put(std::string_view(value));
+          else
+          {
+               std::ostringstream text;
+               text << value;
+               put(text.str());
+          }
+          return *this;
+     }
+
+     OutputBuffer &raw(const void *data, std::size_t bytes)
+     {
+          if (bytes)
+          {
+               std::memcpy(reserve(bytes), data, bytes);
+               used += bytes;
+          }
+          return *this;
+     }
+
+     // one exported element
+     template <typename Key, typename Info>
+     void element(const Key &key, const Info &info, Format format)
+     {
+          switch (format)
+          {
+          case Format::CSV:
+          case Format::TSV:
+               field(key, format);
+               put(format == Format::CSV ? ',' : '\t');
+               field(info, format);
+               put('\n');
+               break;
+          case Format::JSONLines:
+               put("{\"key\":");
+               field(key, format);
+               put(",\"info\":");
+               field(info, format);
+               put("}\n");
+               break;
+          case Format::Binary:
+               binary(key);
+               binary(info);
+               break;
+          }
+     }
+};
@@ -0,0 +1,556 @@
+#pragma once
+#include "output.hpp"
+#include <iostream>
+#include <vector>
+#include <optional>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// fixed-size string key for PagedAVLTree, which stores records by value; longer
+// strings are cut to N - 1 characters
+template <std::size_t N>
+struct FixedKey
+{
+     char data[N];
+
+     FixedKey() : data{} {};
+
+     FixedKey(const std::string &str) : data{}
+     {
+          str.copy(data, N - 1);
+     }
+
+     std::string str() const
+     {
+          return data;
+     }
+
+     bool operator<(const FixedKey &rhs) const
+     {
+          return std::strncmp(data, rhs.data, N) < 0;
+     }
+
+     bool operator>(const FixedKey &rhs) const
+     {
+          return rhs < *this;
+     }
+
+     bool operator==(const FixedKey &rhs) const
+     {
+          return std::strncmp(data, rhs.data, N) == 0;
+     }
+
+     friend std::ostream &operator<<(std::ostream &os, const FixedKey &key)
+     {
+          return os << key.data;
+     }
+};
+
+// AVL tree whose nodes live in pages of a single file: a fixed number of pages is
+// cached in a buffer pool with clock eviction and everything else stays on disk, so
+// the memory used does not grow with the number of keys
+template <typename Key, typename Info>
+class PagedAVLTree
+{
+     static_assert(std::is_trivially_copyable<Key>::value and std::is_trivially_copyable<Info>::value,
+                   "PagedAVLTree stores keys and infos as raw bytes");
+
+     typedef std::uint64_t Id; // record number, 0 for no record
+
+     struct Record
+     { // node structure; left links the free list of removed records
+          Key key;
+          Info info;
+          int height;
+          Id left, right;
+     };
+
+     struct Header
+     { // contents of page 0
+          std::uint64_t magic;
+          std::uint32_t page_size;
+          std::uint32_t record_size;
+          Id root;
+          std::uint64_t size;    // number of keys
+          Id free;               // first removed record
+          std::uint64_t records; // records ever allocated
+     } header;
+
+     struct Frame
+     { // buffer pool slot
+          std::uint64_t page; // 0 when the frame is unused
+          bool dirty;
+          bool referenced; // second chance for the clock hand
+     };
+
+     static const std::uint64_t Magic = 0x4c56416465676150; // "PagedAVL"
+
+     int fd;
+     std::size_t page_size;
+     std::size_t per_page;                                // records per page
+     std::vector<char> memory;                            // page images of the frames
+     std::vector<Frame> frames;
+     std::unordered_map<std::uint64_t, std::size_t> table; // page -> frame
+     std::size_t hand;
+     std::uint64_t hit_count, miss_count;
+
+     static void fail(const char *what)
+     {
+          throw std::runtime_error(std::string(what) + ": " + std::strerror(errno));
+     }
+
+     void read_page(std::uint64_t page, char *buffer)
+     {
+          std::size_t done = 0;
+          while (done < page_size)
+          {
+               ssize_t n = pread(fd, buffer + done, page_size - done, page * page_size + done);
+               if (n < 0)
+                    fail("PagedAVLTree: read failed");
+               if (n == 0)
+                    break;
+               done += n;
+          }
+          // pages past the end of the file have never been written
+          std::memset(buffer + done, 0, page_size - done);
+     }
+
+     void write_page(std::uint64_t page, const char *buffer)
+     {
+          std::size_t done = 0;
+          while (done < page_size)
+          {
+               ssize_t n = pwrite(fd, buffer + done, page_size - done, page * page_size + done);
+               if (n < 0)
+                    fail("PagedAVLTree: write failed");
+               done += n;
+          }
+     }
+
+     // pick a frame for a new page, writing back the page it evicts
+     std::size_t victim()
+     {
+          while (true)
+          {
+               std::size_t f = hand;
+               hand = (hand + 1) % frames.size();
+               Frame &frame = frames[f];
+               if (frame.page == 0)
+                    return f;
+               if (frame.referenced)
+               {
+                    frame.referenced = false;
+                    continue;
+               }
+               if (frame.dirty)
+                    write_page(frame.page, &memory[f * page_size]);
+               table.erase(frame.page);
+               return f;
+          }
+     }
+
+     char *fetch(std::uint64_t page, bool dirty)
+     {
+          std::size_t f;
+          auto it = table.find(page);
+          if (it != table.end())
+          {
+               hit_count++;
+               f = it->second;
+          }
+          else
+          {
+               miss_count++;
+               f = victim();
+               read_page(page, &memory[f * page_size]);
+               frames[f] = {page, false, false};
+               table[page] = f;
+          }
+          frames[f].referenced = true;
+          frames[f].dirty |= dirty;
+          return &memory[f * page_size];
+     }
+
+     // records are copied in and out, so no page stays pinned between calls
+     Record load(Id id)
+     {
+          Record record;
+          std::memcpy(&record, fetch(1 + (id - 1) / per_page, false) + (id - 1) % per_page * sizeof(Record), sizeof(Record));
+          return record;
+     }
+
+     void store(Id id, const Record &record)
+     {
+          std::memcpy(fetch(1 + (id - 1) / per_page, true) + (id - 1) % per_page * sizeof(Record), &record, sizeof(Record));
+     }
+
+     Id allocate(const Record &record)
+     {
+          Id id = header.free;
+          if (id)
+               header.free = load(id).left;
+          else
+               id = ++header.records;
+          store(id, record);
+          return id;
+     }
+
+     void release(Id id)
+     {
+          Record record{};
+          record.left = header.free;
+          store(id, record);
+          header.free = id;
+     }
+
+     Id find(Id id, const Key &key)
+     {
+          while (id)
+          {
+               Record node = load(id);
+               if (key < node.key)
+                    id = node.left;
+               else if (key > node.key)
+                    id = node.right;
+               else
+                    return id;
+          }
+          return id;
+     }
+
+     int height(Id id)
+     {
+          if (id)
+               return load(id).height;
+          return -1;
+     }
+
+     // rotations and balance take the loaded copy of the node at id and store it
+
+     Id rotr(Id id, Record &node)
+     {
+          Id top = node.left;
+          Record left = load(top);
+          node.left = left.right;
+          node.height = 1 + std::max(height(node.left), height(node.right));
+          store(id, node);
+          left.right = id;
+          left.height = 1 + std::max(height(left.left), node.height);
+          store(top, left);
+          return top;
+     }
+
+     Id lotr(Id id, Record &node)
+     {
+          Id top = node.right;
+          Record right = load(top);
+          node.right = right.left;
+          node.height = 1 + std::max(height(node.left), height(node.right));
+          store(id, node);
+          right.left = id;
+          right.height = 1 + std::max(node.height, height(right.right));
+          store(top, right);
+          return top;
+     }
+
+     Id balance(Id id, Record &node)
+     {
+          int hl = height(node.left), hr = height(node.right);
+          node.height = 1 + std::max(hl, hr);
+          if (hl - hr > 1)
+          {
+               Record left = load(node.left);
+               if (height(left.left) < height(left.right))
+                    node.left = lotr(node.left, left);
+               return rotr(id, node);
+          }
+          if (hr - hl > 1)
+          {
+               Record right = load(node.right);
+               if (height(right.right) < height(right.left))
+                    node.right = rotr(node.right, right);
+               return lotr(id, node);
+          }
+          store(id, node);
+          return id;
+     }
+
+     Id insert(Id id, const Key &key, const Info &info, bool &inserted)
+     {
+          if (id == 0)
+          {
+               inserted = true;
+               return allocate(Record{key, info, 0, 0, 0});
+          }
+          Record node = load(id);
+          if (key < node.key)
+          {
+               Id left = insert(node.left, key, info, inserted);
+               if (!inserted)
+                    return id;
+               node.left = left;
+          }
+          else if (key > node.key)
+          {
+               Id right = insert(node.right, key, info, inserted);
+               if (!inserted)
+                    return id;
+               node.right = right;
+          }
+          else
+               return id;
+          return balance(id, node);
+     }
+
+     // detach the smallest record of a non-empty subtree into min
+     Id remove_min(Id id, Id &min)
+     {
+          Record node = load(id);
+          if (node.left == 0)
+          {
+               min = id;
+               return node.right;
+          }
+          node.left = remove_min(node.left, min);
+          return balance(id, node);
+     }
+
+     Id remove(Id id, const Key &key, bool &removed)
+     {
+          if (id == 0)
+               return id;
+          Record node = load(id);
+          if (key < node.key)
+          {
+               Id left = remove(node.left, key, removed);
+               if (!removed)
+                    return id;
+               node.left = left;
+          }
+          else if (key > node.key)
+          {
+               Id right = remove(node.right, key, removed);
+               if (!removed)
+                    return id;
+               node.right = right;
+          }
+          else
+          {
+               removed = true;
+               release(id);
+               if (node.left == 0 or node.right == 0)
+                    return node.left ? node.left : node.right;
+               Id min;
+               Id right = remove_min(node.right, min);
+               Record successor = load(min);
+               successor.left = node.left;
+               successor.right = right;
+               return balance(min, successor);
+          }
+          return balance(id, node);
+     }
+
+public:
+     // opens the tree stored in path, or creates it; pool_pages pages of page_size
+     // bytes are kept in memory
+     PagedAVLTree(const std::string &path, std::size_t pool_pages = 256, std::size_t page_size = 4096)
+         : page_size(page_size), per_page(page_size / sizeof(Record)), memory(pool_pages * page_size),
+           frames(pool_pages, Frame{0, false, false}), hand(0), hit_count(0), miss_count(0)
+     {
+          if (page_size < 4096 or page_size > 16384 or page_size % 512)
+               throw std::invalid_argument("PagedAVLTree: page size must be a multiple of 512 between 4 and 16 KB");
+          if (pool_pages == 0 or per_page == 0)
+               throw std::invalid_argument("PagedAVLTree: the pool must hold at least one page of records");
+          fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+          if (fd < 0)
+               fail("PagedAVLTree: cannot open file");
+          struct stat st;
+          if (fstat(fd, &st) < 0)
+          {
+               int error = errno;
+               close(fd);
+               errno = error;
+               fail("PagedAVLTree: cannot stat file");
+          }
+          header = Header{Magic, std::uint32_t(page_size), sizeof(Record), 0, 0, 0, 0};
+          if (st.st_size == 0)
+               return;
+          Header stored;
+          if (pread(fd, &stored, sizeof(stored), 0) != ssize_t(sizeof(stored)) or stored.magic != Magic or
+              stored.page_size != page_size or stored.record_size != sizeof(Record))
+          {
+               close(fd);
+               throw std::runtime_error("PagedAVLTree: " + path + " does not hold a tree of this layout");
+          }
+          header = stored;
+     }
+
+     PagedAVLTree(const PagedAVLTree &) = delete;
+
+     PagedAVLTree &operator=(const PagedAVLTree &) = delete;
+
+     ~PagedAVLTree()
+     {
+          try
+          {
+               flush();
+          }
+          catch (const std::exception &e)
+          {
+               std::cerr << e.what() << "\n";
+          }
+          close(fd);
+     }
+
+     bool empty() const
+     {
+          return header.size == 0;
+     }
+
+     bool exists(const Key &key)
+     {
+          return find(header.root, key) != 0;
+     }
+
+     bool insert(const Key &key, const Info &info)
+     {
+          bool inserted = false;
+          header.root = insert(header.root, key, info, inserted);
+          if (inserted)
+               header.size++;
+          return inserted;
+     }
+
+     bool remove(const Key &key)
+     {
+          bool removed = false;
+          header.root = remove(header.root, key, removed);
+          if (removed)
+               header.size--;
+          return removed;
+     }
+
+     // returns a copy, since the page holding the record may be evicted at any time
+     Info find(const Key &key)
+     {
+          std::optional<Info> info = try_find(key);
+          if (info)
+               return *info;
+          throw "Element with given key does not exist!";
+     }
+
+     // like find, but a missing key gives an empty optional instead of an exception
+     std::optional<Info> try_find(const Key &key)
+     {
+          Id id = find(header.root, key);
+          if (id)
+               return load(id).info;
+          return std::nullopt;
+     }
+
+     // the info of key, or fallback when key is missing
+     Info find_or(const Key &key, const Info &fallback)
+     {
+          return try_find(key).value_or(fallback);
+     }
+
+     // replace the info of an existing key
+     bool update(const Key &key, const Info &info)
+     {
+          Id id = find(header.root, key);
+          if (id == 0)
+               return false;
+          Record node = load(id);
+          node.info = info;
+          store(id, node);
+          return true;
+     }
+
+     int count() const
+     {
+          return header.size;
+     }
+
+     int height()
+     {
+          return height(header.root);
+     }
+
+     void clear()
+     {
+          table.clear();
+          std::fill(frames.begin(), frames.end(), Frame{0, false, false});
+          header = Header{Magic, std::uint32_t(page_size), sizeof(Record), 0, 0, 0, 0};
+          if (ftruncate(fd, 0) < 0)
+               fail("PagedAVLTree: cannot truncate file");
+     }
+
+     // write all dirty pages and the header back to the file
+     void flush()
+     {
+          for (std::size_t f = 0; f < frames.size(); f++)
+               if (frames[f].page and frames[f].dirty)
+               {
+                    write_page(frames[f].page, &memory[f * page_size]);
+                    frames[f].dirty = false;
+               }
+          if (pwrite(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header)))
+               fail("PagedAVLTree: write failed");
+     }
+
+     // buffer pool statistics
+     std::uint64_t hits() const
+     {
+          return hit_count;
+     }
+
+     std::uint64_t misses() const
+     {
+          return miss_count;
+     }
+
+     // visit the keys in order without holding more than one path in memory
+     template <typename Visit>
+     void for_each(Visit visit)
+     {
+          std::vector<Id> path;
+          Id id = header.root;
+          while (id or !path.empty())
+          {
+               while (id)
+               {
+                    path.push_back(id);
+                    id = load(id).left;
+               }
+               Record node = load(path.back());
+               path.pop_back();
+               visit(node.key, node.info);
+               id = node.right;
+          }
+     }
+
+     // same format as AVLTree::print_inorder
+     void print_inorder()
+     {
+          OutputBuffer out;
+          for_each([&out](const Key &key, const Info &info)
+                   { out.put('(').put(key).put(", ").put(info).put("),  "); });
+     }
+
+     std::vector<std::pair<Key, Info>> get_elements()
+     {
+          std::vector<std::pair<Key, Info>> elements;
+          for_each([&elements](const Key &key, const Info &info)
+                   { elements.emplace_back(key, info); });
+          return elements;
+     }
+};
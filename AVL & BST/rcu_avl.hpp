@@ -0,0 +1,374 @@
+#pragma once
+#include "epoch.hpp"
+#include <iostream>
+#include <vector>
+#include <optional>
+#include <algorithm>
+
+// AVL tree for one writer and many lock-free readers: published nodes are never
+// modified, updates copy the nodes they touch and publish a new root, and the
+// replaced nodes are freed through epoch-based reclamation
+template <typename Key, typename Info>
+class RCUAVLTree
+{
+     struct Node
+     { // node structure
+          Key key;
+          Info info;
+          int height;
+          std::uint64_t version; // update that created the node; only that update may change it
+          Node *left, *right;    // left and right nodes
+          Node(const Key &key, const Info &info, std::uint64_t version) : key(key), info(info), height(0), version(version), left(nullptr), right(nullptr){};
+     };
+
+     std::atomic<Node *> root;     // published root
+     std::atomic<int> size;        // number of keys in the published tree
+     mutable EpochManager epochs;  // reader announcements and retired nodes
+     std::mutex writer;            // serialises updates
+     std::uint64_t version;        // number of the running update
+     std::vector<Node *> garbage;  // nodes replaced by the running update
+
+     static void dispose(void *node)
+     {
+          delete static_cast<Node *>(node);
+     }
+
+     static const Node *find(const Node *node, const Key &key)
+     {
+          while (node)
+          {
+               if (key < node->key)
+                    node = node->left;
+               else if (key > node->key)
+                    node = node->right;
+               else
+                    return node;
+          }
+          return node;
+     }
+
+     // calculate height
+     static int height(const Node *node)
+     {
+          if (node)
+               return node->height;
+          return -1;
+     }
+
+     // returns a node the running update may modify, copying a published one
+     Node *fresh(Node *node)
+     {
+          if (node->version == version)
+               return node;
+          Node *copy = new Node(*node);
+          copy->version = version;
+          garbage.push_back(node);
+          return copy;
+     }
+
+     // rotate right
+     Node *rotr(Node *y)
+     {
+          y = fresh(y);
+          Node *x = fresh(y->left);
+          y->left = x->right;
+          x->right = y;
+          y->height = std::max(height(y->left), height(y->right)) + 1;
+          x->height = std::max(height(x->left), height(x->right)) + 1;
+          return x;
+     }
+
+     // rotate left
+     Node *lotr(Node *x)
+     {
+          x = fresh(x);
+          Node *y = fresh(x->right);
+          x->right = y->left;
+          y->left = x;
+          x->height = std::max(height(x->left), height(x->right)) + 1;
+          y->height = std::max(height(y->left), height(y->right)) + 1;
+          return y;
+     }
+
+     // update the height of a fresh node and restore its balance
+     Node *balance(Node *node)
+     {
+          node->height = 1 + std::max(height(node->left), height(node->right));
+          int b = height(node->left) - height(node->right);
+          if (b > 1)
+          {
+               if (height(node->left->left) < height(node->left->right))
+                    node->left = lotr(node->left);
+               return rotr(node);
+          }
+          if (b < -1)
+          {
+               if (height(node->right->right) < height(node->right->left))
+                    node->right = rotr(node->right);
+               return lotr(node);
+          }
+          return node;
+     }
+
+     // insert a node, copying the search path; unchanged subtrees are shared
+     Node *insert(Node *node, const Key &key, const Info &info, bool &inserted)
+     {
+          if (node == nullptr)
+          {
+               inserted = true;
+               return new Node(key, info, version);
+          }
+          if (key < node->key)
+          {
+               Node *left = insert(node->left, key, info, inserted);
+               if (!inserted)
+                    return node;
+               node = fresh(node);
+               node->left = left;
+          }
+          else if (key > node->key)
+          {
+               Node *right = insert(node->right, key, info, inserted);
+               if (!inserted)
+                    return node;
+               node = fresh(node);
+               node->right = right;
+          }
+          else
+               return node;
+          return balance(node);
+     }
+
+     // detach the smallest node of a non-empty subtree into min
+     Node *remove_min(Node *node, Node *&min)
+     {
+          if (node->left == nullptr)
+          {
+               min = node;
+               return node->right;
+          }
+          Node *left = remove_min(node->left, min);
+          node = fresh(node);
+          node->left = left;
+          return balance(node);
+     }
+
+     // delete a node, copying the search path
+     Node *remove(Node *node, const Key &key, bool &removed)
+     {
+          if (node == nullptr)
+               return node;
+          if (key < node->key)
+          {
+               Node *left = remove(node->left, key, removed);
+               if (!removed)
+                    return node;
+               node = fresh(node);
+               node->left = left;
+          }
+          else if (key > node->key)
+          {
+               Node *right = remove(node->right, key, removed);
+               if (!removed)
+                    return node;
+               node = fresh(node);
+               node->right = right;
+          }
+          else
+          {
+               removed = true;
+               garbage.push_back(node);
+               if (node->left == nullptr)
+                    return node->right;
+               if (node->right == nullptr)
+                    return node->left;
+               Node *min;
+               Node *right = remove_min(node->right, min);
+               Node *top = fresh(min);
+               top->left = node->left;
+               top->right = right;
+               node = top;
+          }
+          return balance(node);
+     }
+
+     // replace the info of a node, copying the search path
+     Node *modify(Node *node, const Key &key, const Info &info, bool &modified)
+     {
+          if (node == nullptr)
+               return node;
+          Node *child;
+          if (key < node->key)
+          {
+               child = modify(node->left, key, info, modified);
+               if (modified)
+                    (node = fresh(node))->left = child;
+          }
+          else if (key > node->key)
+          {
+               child = modify(node->right, key, info, modified);
+               if (modified)
+                    (node = fresh(node))->right = child;
+          }
+          else
+          {
+               modified = true;
+               node = fresh(node);
+               node->info = info;
+          }
+          return node;
+     }
+
+     void collect(Node *node, std::vector<Node *> &nodes)
+     {
+          if (node)
+          {
+               nodes.push_back(node);
+               collect(node->left, nodes);
+               collect(node->right, nodes);
+          }
+     }
+
+     void get_elements(std::vector<std::pair<Key, Info>> &elements, const Node *node) const
+     {
+          if (node)
+          {
+               get_elements(elements, node->left);
+               elements.emplace_back(node->key, node->info);
+               get_elements(elements, node->right);
+          }
+     }
+
+     // make the new root visible to readers, then retire what it replaced
+     void publish(Node *fresh_root)
+     {
+          root.store(fresh_root, std::memory_order_release);
+          for (Node *node : garbage)
+               epochs.retire(node, dispose);
+          garbage.clear();
+          epochs.reclaim();
+     }
+
+public:
+     RCUAVLTree() : root(nullptr), size(0), version(0){};
+
+     RCUAVLTree(const RCUAVLTree &) = delete;
+
+     RCUAVLTree &operator=(const RCUAVLTree &) = delete;
+
+     // no reader may be left when the tree is destroyed
+     ~RCUAVLTree()
+     {
+          std::vector<Node *> nodes;
+          collect(root.load(), nodes);
+          for (Node *node : nodes)
+               delete node;
+     }
+
+     // readers
+
+     bool empty() const
+     {
+          return count() == 0;
+     }
+
+     bool exists(const Key &key) const
+     {
+          EpochManager::Guard guard(epochs);
+          return find(root.load(std::memory_order_acquire), key) != nullptr;
+     }
+
+     // returns a copy, since the node may be retired as soon as the reader leaves
+     Info find(const Key &key) const
+     {
+          std::optional<Info> info = try_find(key);
+          if (info)
+               return *info;
+          throw "Element with given key does not exist!";
+     }
+
+     // like find, but a missing key gives an empty optional instead of an exception
+     std::optional<Info> try_find(const Key &key) const
+     {
+          EpochManager::Guard guard(epochs);
+          const Node *node = find(root.load(std::memory_order_acquire), key);
+          if (node)
+               return node->info;
+          return std::nullopt;
+     }
+
+     // the info of key, or fallback when key is missing
+     Info find_or(const Key &key, const Info &fallback) const
+     {
+          return try_find(key).value_or(fallback);
+     }
+
+     int count() const
+     {
+          return size.load(std::memory_order_acquire);
+     }
+
+     int height() const
+     {
+          EpochManager::Guard guard(epochs);
+          return height(root.load(std::memory_order_acquire));
+     }
+
+     // consistent snapshot of one published version
+     std::vector<std::pair<Key, Info>> get_elements() const
+     {
+          EpochManager::Guard guard(epochs);
+          std::vector<std::pair<Key, Info>> elements;
+          get_elements(elements, root.load(std::memory_order_acquire));
+          return elements;
+     }
+
+     // writers
+
+     bool insert(const Key &key, const Info &info)
+     {
+          std::lock_guard<std::mutex> lock(writer);
+          version++;
+          bool inserted = false;
+          Node *fresh_root = insert(root.load(std::memory_order_relaxed), key, info, inserted);
+          if (inserted)
+          {
+               publish(fresh_root);
+               size.fetch_add(1, std::memory_order_release);
+          }
+          return inserted;
+     }
+
+     bool remove(const Key &key)
+     {
+          std::lock_guard<std::mutex> lock(writer);
+          version++;
+          bool removed = false;
+          Node *fresh_root = remove(root.load(std::memory_order_relaxed), key, removed);
+          if (removed)
+          {
+               publish(fresh_root);
+               size.fetch_sub(1, std::memory_order_release);
+          }
+          return removed;
+     }
+
+     bool modify(const Key &key, const Info &info)
+     {
+          std::lock_guard<std::mutex> lock(writer);
+          version++;
+          bool modified = false;
+          Node *fresh_root = modify(root.load(std::memory_order_relaxed), key, info, modified);
+          if (modified)
+               publish(fresh_root);
+          return modified;
+     }
+
+     void clear()
+     {
+          std::lock_guard<std::mutex> lock(writer);
+          collect(root.load(std::memory_order_relaxed), garbage);
+          publish(nullptr);
+          size.store(0, std::memory_order_release);
+     }
+};
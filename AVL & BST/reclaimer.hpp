@@ -0,0 +1,110 @@
+#pragma once
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <algorithm>
+#include <functional>
+#include <cstddef>
+
+// background thread that frees detached data structures a chunk at a time, so the
+// thread that drops a large structure does not pay for freeing it
+class Reclaimer
+{
+     struct Job
+     {
+          std::function<std::size_t()> step; // frees one chunk, returns how many items it freed
+          std::size_t left;                  // items not freed yet
+     };
+
+     std::mutex lock;
+     std::condition_variable work, done;
+     std::deque<Job> jobs;
+     std::size_t outstanding; // items of all jobs not freed yet
+     bool stopping;
+     std::thread worker;
+
+     Reclaimer() : outstanding(0), stopping(false){};
+
+     void run()
+     {
+          std::unique_lock<std::mutex> guard(lock);
+          while (true)
+          {
+               work.wait(guard, [this]()
+                         { return stopping or !jobs.empty(); });
+               if (jobs.empty())
+                    return;
+               Job job = std::move(jobs.front());
+               jobs.pop_front();
+               guard.unlock();
+               std::size_t freed = job.step();
+               guard.lock();
+               freed = std::min(freed, job.left);
+               job.left -= freed;
+               outstanding -= freed;
+               // a job goes to the back after each chunk, so a huge structure does
+               // not hold up the ones queued after it
+               if (freed and job.left)
+                    jobs.push_back(std::move(job));
+               else
+                    outstanding -= job.left;
+               if (outstanding == 0)
+                    done.notify_all();
+          }
+     }
+
+public:
+     static const std::size_t Chunk = 65536; // items a step should free
+
+     static Reclaimer &instance()
+     {
+          static Reclaimer reclaimer;
+          return reclaimer;
+     }
+
+     Reclaimer(const Reclaimer &) = delete;
+
+     Reclaimer &operator=(const Reclaimer &) = delete;
+
+     // everything submitted is freed before the program exits
+     ~Reclaimer()
+     {
+          {
+               std::lock_guard<std::mutex> guard(lock);
+               stopping = true;
+          }
+          work.notify_all();
+          if (worker.joinable())
+               worker.join();
+     }
+
+     // hand over a structure of items items; step is called until it has freed them
+     // all or frees nothing
+     void submit(std::function<std::size_t()> step, std::size_t items)
+     {
+          {
+               std::lock_guard<std::mutex> guard(lock);
+               jobs.push_back({std::move(step), items});
+               outstanding += items;
+               if (!worker.joinable())
+                    worker = std::thread(&Reclaimer::run, this);
+          }
+          work.notify_one();
+     }
+
+     // number of items waiting to be freed
+     std::size_t pending()
+     {
+          std::lock_guard<std::mutex> guard(lock);
+          return outstanding;
+     }
+
+     // block until everything submitted so far is freed
+     void wait()
+     {
+          std::unique_lock<std::mutex> guard(lock);
+          done.wait(guard, [this]()
+                    { return outstanding == 0; });
+     }
+};
@@ -0,0 +1,174 @@
+#pragma once
+#include "avl.hpp"
+#include <mutex>
+#include <optional>
+#include <functional>
+#include <queue>
+#include <cstdint>
+
+// dictionary split by key hash into N independently locked AVLTree shards, so that
+// writers touching different shards never wait for each other
+template <typename Key, typename Info, std::size_t N = 16>
+class ShardedAVLMap
+{
+     struct alignas(64) Shard
+     { // shard structure, padded to its own cache line
+          mutable std::mutex lock;
+          AVLTree<Key, Info> tree;
+     } shards[N];
+
+     // std::hash is the identity for integers, so mix the bits before taking the shard
+     static std::size_t route(const Key &key)
+     {
+          std::uint64_t h = std::hash<Key>{}(key);
+          h ^= h >> 33;
+          h *= 0xff51afd7ed558ccdULL;
+          h ^= h >> 33;
+          return h % N;
+     }
+
+     Shard &shard(const Key &key)
+     {
+          return shards[route(key)];
+     }
+
+     const Shard &shard(const Key &key) const
+     {
+          return shards[route(key)];
+     }
+
+public:
+     ShardedAVLMap() = default;
+
+     ShardedAVLMap(const ShardedAVLMap &) = delete;
+
+     ShardedAVLMap &operator=(const ShardedAVLMap &) = delete;
+
+     bool empty() const
+     {
+          return count() == 0;
+     }
+
+     bool exists(const Key &key) const
+     {
+          const Shard &s = shard(key);
+          std::lock_guard<std::mutex> guard(s.lock);
+          return s.tree.exists(key);
+     }
+
+     bool insert(const Key &key, const Info &info)
+     {
+          Shard &s = shard(key);
+          std::lock_guard<std::mutex> guard(s.lock);
+          return s.tree.insert(key, info);
+     }
+
+     bool remove(const Key &key)
+     {
+          Shard &s = shard(key);
+          std::lock_guard<std::mutex> guard(s.lock);
+          return s.tree.remove(key);
+     }
+
+     // insert info if the key is absent, otherwise call update on the stored info
+     template <typename Update>
+     void upsert(const Key &key, const Info &info, Update update)
+     {
+          Shard &s = shard(key);
+          std::lock_guard<std::mutex> guard(s.lock);
+          if (!s.tree.insert(key, info))
+               update(s.tree[key]);
+     }
+
+     // add delta to the key's info, inserting delta if the key is absent
+     void upsert(const Key &key, const Info &delta)
+     {
+          upsert(key, delta, [&delta](Info &info)
+                 { info += delta; });
+     }
+
+     // returns a copy, since the stored info may change as soon as the shard is unlocked
+     Info find(const Key &key) const
+     {
+          const Shard &s = shard(key);
+          std::lock_guard<std::mutex> guard(s.lock);
+          return s.tree.find(key);
+     }
+
+     // like find, but a missing key gives an empty optional instead of an exception
+     std::optional<Info> try_find(const Key &key) const
+     {
+          const Shard &s = shard(key);
+          std::lock_guard<std::mutex> guard(s.lock);
+          const Info *info = s.tree.try_find(key);
+          if (info)
+               return *info;
+          return std::nullopt;
+     }
+
+     // the info of key, or fallback when key is missing
+     Info find_or(const Key &key, const Info &fallback) const
+     {
+          return try_find(key).value_or(fallback);
+     }
+
+     int count() const
+     {
+          int total = 0;
+          for (const Shard &s : shards)
+          {
+               std::lock_guard<std::mutex> guard(s.lock);
+               total += s.tree.count();
+          }
+          return total;
+     }
+
+     void clear()
+     {
+          for (Shard &s : shards)
+          {
+               std::lock_guard<std::mutex> guard(s.lock);
+               s.tree.clear();
+          }
+     }
+
+     // visit all elements in key order; each shard is snapshotted under its own lock
+     // and the snapshots are merged, so only one shard is locked at a time
+     template <typename Visit>
+     void for_each(Visit visit) const
+     {
+          std::vector<std::pair<Key, Info>> parts[N];
+          for (std::size_t i = 0; i < N; i++)
+          {
+               std::lock_guard<std::mutex> guard(shards[i].lock);
+               parts[i] = shards[i].tree.get_elements();
+          }
+
+          // min-heap of (shard, position) ordered by the key at that position
+          auto later = [&parts](const std::pair<std::size_t, std::size_t> &lhs, const std::pair<std::size_t, std::size_t> &rhs)
+          {
+               return parts[rhs.first][rhs.second].first < parts[lhs.first][lhs.second].first;
+          };
+          std::priority_queue<std::pair<std::size_t, std::size_t>, std::vector<std::pair<std::size_t, std::size_t>>, decltype(later)> heap(later);
+          for (std::size_t i = 0; i < N; i++)
+               if (!parts[i].empty())
+                    heap.emplace(i, 0);
+          while (!heap.empty())
+          {
+               auto top = heap.top();
+               heap.pop();
+               const std::pair<Key, Info> &ele = parts[top.first][top.second];
+               visit(ele.first, ele.second);
+               if (++top.second < parts[top.first].size())
+                    heap.push(top);
+          }
+     }
+
+     std::vector<std::pair<Key, Info>> get_elements() const
+     {
+          std::vector<std::pair<Key, Info>> elements;
+          for_each([&elements](const Key &key, const Info &info)
+                   { elements.emplace_back(key, info); });
+          return elements;
+     }
+};
@@ -0,0 +1,134 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+// read-only dictionary of up to N elements that can be built at compile time; the
+// elements are kept in a complete binary search tree stored breadth-first (Eytzinger
+// layout), so a lookup walks one array with no pointers and no initialization at run
+// time, and the tree is as balanced as any AVLTree holding the same keys
+template <typename Key, typename Info, std::size_t N>
+class StaticAVL
+{
+     struct Entry
+     {
+          Key key;
+          Info info;
+     };
+
+     Entry nodes[N + 1]; // nodes[1] is the root, nodes[i] has children 2i and 2i + 1
+     std::size_t size;
+
+     // place sorted in order into the subtree rooted at at, returns the next unplaced element
+     constexpr std::size_t layout(const Entry *sorted, std::size_t next, std::size_t at)
+     {
+          if (at <= size)
+          {
+               next = layout(sorted, next, 2 * at);
+               nodes[at] = sorted[next++];
+               next = layout(sorted, next, 2 * at + 1);
+          }
+          return next;
+     }
+
+     void get_elements(std::vector<std::pair<Key, Info>> &elements, std::size_t at) const
+     {
+          if (at <= size)
+          {
+               get_elements(elements, 2 * at);
+               elements.emplace_back(nodes[at].key, nodes[at].info);
+               get_elements(elements, 2 * at + 1);
+          }
+     }
+
+public:
+     // the elements in order of insertion; like AVLTree::insert, a repeated key keeps
+     // its first info
+     constexpr StaticAVL(const std::pair<Key, Info> (&elements)[N]) : nodes{}, size(0)
+     {
+          // insertion sort is stable and constexpr, and the tables are small
+          Entry sorted[N + 1] = {};
+          for (std::size_t i = 0; i < N; i++)
+          {
+               std::size_t at = size;
+               while (at > 0 and elements[i].first < sorted[at - 1].key)
+                    at--;
+               if (at > 0 and !(sorted[at - 1].key < elements[i].first))
+                    continue;
+               for (std::size_t j = size; j > at; j--)
+                    sorted[j] = sorted[j - 1];
+               sorted[at] = Entry{elements[i].first, elements[i].second};
+               size++;
+          }
+          layout(sorted, 0, 1);
+     }
+
+     constexpr const Info *try_find(const Key &key) const
+     {
+          std::size_t at = 1;
+          while (at <= size)
+          {
+               if (key < nodes[at].key)
+                    at = 2 * at;
+               else if (key > nodes[at].key)
+                    at = 2 * at + 1;
+               else
+                    return &nodes[at].info;
+          }
+          return nullptr;
+     }
+
+     constexpr bool exists(const Key &key) const
+     {
+          return try_find(key) != nullptr;
+     }
+
+     constexpr const Info &find(const Key &key) const
+     {
+          const Info *info = try_find(key);
+          if (!info)
+               throw "Element with given key does not exist!";
+          return *info;
+     }
+
+     // the info of key, or fallback when key is missing
+     constexpr Info find_or(const Key &key, const Info &fallback) const
+     {
+          const Info *info = try_find(key);
+          return info ? *info : fallback;
+     }
+
+     constexpr const Info &operator[](const Key &key) const
+     {
+          return find(key);
+     }
+
+     constexpr int count() const
+     {
+          return int(size);
+     }
+
+     constexpr int height() const
+     {
+          int levels = -1;
+          for (std::size_t at = size; at; at /= 2)
+               levels++;
+          return levels;
+     }
+
+     std::vector<std::pair<Key, Info>> get_elements() const
+     {
+          std::vector<std::pair<Key, Info>> elements;
+          elements.reserve(size);
+          get_elements(elements, 1);
+          return elements;
+     }
+};
+
+// make_static_avl<std::string_view, int>({{"a", 1}, {"b", 2}}) sizes the table from
+// the list; declare the result constexpr to build it at compile time
+template <typename Key, typename Info, std::size_t N>
+constexpr StaticAVL<Key, Info, N> make_static_avl(const std::pair<Key, Info> (&elements)[N])
+{
+     return StaticAVL<Key, Info, N>(elements);
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include "avl.hpp"
+#include "checkpoint.hpp"
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <exception>
+#include <cctype>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+
+struct StreamOptions
+{
+     std::chrono::milliseconds interval{1000}; // time between snapshots
+     std::size_t top = 0;                      // words per snapshot, 0 for all of them
+     bool follow = false;                      // at end of input wait for more, like tail -f
+     std::size_t chunk = 65536;                // bytes read at a time
+     const std::atomic<bool> *stop = nullptr;  // ends the stream when set
+     CountCheckpoint *checkpoint = nullptr;    // logs the counts every interval, already recovered
+     int snapshot_every = 16;                  // intervals between full snapshots, 0 for never
+
+     // receives each snapshot, most frequent words first; prints it when empty
+     std::function<void(const std::vector<std::pair<std::string, int>> &)> emit;
+};
+
+// print a snapshot in the format of listing
+void print_snapshot(const std::vector<std::pair<std::string, int>> &words)
+{
+     OutputBuffer out;
+     for (auto &ele : words)
+          out.put(ele.first).put(": ").put(ele.second).put('\n');
+     out.put('\n');
+}
+
+// the top most frequent of the given words, or all of them when top is 0
+std::vector<std::pair<std::string, int>> top_words(std::vector<std::pair<std::string, int>> elements, std::size_t top = 0)
+{
+     auto descending = [](const std::pair<std::string, int> &lhs, const std::pair<std::string, int> &rhs)
+     { return compare(rhs, lhs); };
+     if (top and top < elements.size())
+     {
+          std::partial_sort(elements.begin(), elements.begin() + top, elements.end(), descending);
+          elements.resize(top);
+     }
+     else
+          std::sort(elements.begin(), elements.end(), descending);
+     return elements;
+}
+
+// the top most frequent words of dict, or all of them when top is 0
+std::vector<std::pair<std::string, int>> top_words(const AVLTree<std::string, int> &dict, std::size_t top = 0)
+{
+     return top_words(dict.get_elements(), top);
+}
+
+// count the words read from fd into dict until end of input (or until stop is set,
+// when following), while a background thread emits a snapshot every interval and
+// once more at the end; memory stays at the vocabulary plus one chunk
+//
+// with a checkpoint, fd must be positioned at checkpoint->position() and dict must
+// hold what the checkpoint recovered; each interval then syncs the log, and every
+// snapshot_every intervals writes a new snapshot instead
+void stream_counter(int fd, AVLTree<std::string, int> &dict, const StreamOptions &options = StreamOptions())
+{
+     std::mutex lock; // held by the reader for a chunk and by the snapshot for a copy
+     std::condition_variable wake;
+     bool done = false;
+     std::exception_ptr failure; // first error of the checkpoint
+     CountCheckpoint *checkpoint = options.checkpoint;
+     std::uint64_t consumed = checkpoint ? checkpoint->position() : 0; // input position after the last chunk
+     std::string word;                                                  // may continue into the next chunk
+     auto count = [&](const std::string &complete)
+     {
+          count_word(dict, complete);
+          if (checkpoint)
+               checkpoint->record(complete);
+     };
+     std::function<void(const std::vector<std::pair<std::string, int>> &)> emit = options.emit;
+     if (!emit)
+          emit = print_snapshot;
+     auto stopped = [&options]()
+     { return options.stop and options.stop->load(); };
+
+     std::thread snapshots([&]()
+                           {
+          std::unique_lock<std::mutex> guard(lock);
+          int ticks = 0;
+          while (!wake.wait_for(guard, options.interval, [&done]()
+                                { return done; }))
+          {
+               // only the copies hold up the reader; sorting, writing and syncing
+               // run without the lock
+               bool logging = checkpoint and !failure;
+               bool full = logging and options.snapshot_every and ++ticks % options.snapshot_every == 0;
+               // words cut by the chunk boundary are read again after a restart
+               std::uint64_t position = consumed - word.size();
+               auto elements = full ? checkpoint->take_snapshot(dict) : dict.get_elements();
+               std::string batch;
+               if (logging and !full)
+                    batch = checkpoint->take_batch(position);
+               guard.unlock();
+               std::exception_ptr error;
+               if (logging)
+                    try
+                    {
+                         if (full)
+                              checkpoint->write_snapshot(elements, position);
+                         else
+                              checkpoint->write_batch(batch, position);
+                    }
+                    catch (...)
+                    {
+                         error = std::current_exception();
+                    }
+               emit(top_words(std::move(elements), options.top));
+               guard.lock();
+               if (error)
+                    failure = error;
+          } });
+
+     std::vector<char> buffer(std::max<std::size_t>(options.chunk, 1));
+     bool ended = false; // the whole input was read
+     while (!stopped())
+     {
+          // poll, so that a set stop flag is noticed while the input is idle
+          pollfd ready = {fd, POLLIN, 0};
+          if (poll(&ready, 1, 100) == 0)
+               continue;
+          ssize_t got = read(fd, buffer.data(), buffer.size());
+          if (got < 0 and errno == EINTR)
+               continue;
+          if (got <= 0)
+          {
+               if (got < 0 or !options.follow)
+               {
+                    ended = got == 0;
+                    break;
+               }
+               // a growing file reads as ended until more is appended
+               std::this_thread::sleep_for(std::chrono::milliseconds(50));
+               continue;
+          }
+          std::lock_guard<std::mutex> guard(lock);
+          if (failure)
+               break;
+          for (ssize_t i = 0; i < got; i++)
+          {
+               if (std::isspace(static_cast<unsigned char>(buffer[i])))
+               {
+                    if (!word.empty())
+                         count(word);
+                    word.clear();
+               }
+               else
+                    word += buffer[i];
+          }
+          consumed += got;
+     }
+
+     {
+          std::lock_guard<std::mutex> guard(lock);
+          // after a stop, a restart from the checkpoint reads the last word again
+          if (!word.empty() and (ended or !checkpoint))
+          {
+               count(word);
+               word.clear();
+          }
+          done = true;
+     }
+     wake.notify_one();
+     snapshots.join();
+     if (failure)
+          std::rethrow_exception(failure);
+     if (checkpoint)
+          checkpoint->sync(consumed - word.size());
+     emit(top_words(dict, options.top));
+}
@@ -1,10 +1,32 @@
 #include "avl.hpp"
 #include "bst.hpp"
+#include "buffered_avl.hpp"
+#include "sharded_avl.hpp"
+#include "rcu_avl.hpp"
+#include "concurrent_avl.hpp"
+#include "bptree.hpp"
+#include "paged_avl.hpp"
+#include "stream.hpp"
+#include "static_avl.hpp"
 #include <vector>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
 
 using namespace std;
 
+// ordered key without a std::hash
+struct Point
+{
+   int x, y;
+   bool operator<(const Point &rhs) const { return x < rhs.x or (x == rhs.x and y < rhs.y); }
+   bool operator>(const Point &rhs) const { return rhs < *this; }
+   bool operator==(const Point &rhs) const { return x == rhs.x and y == rhs.y; }
+};
+
 template <typename Key, typename Info>
 AVLTree<Key, Info> vec2avl(const vector<pair<Key, Info>> &vec)
 {
@@ -162,6 +184,838 @@ int main()
       listing(avl);
    }*/
 
+   // TEST 10: remove_range, remove_batch and lazy removal
+   {
+      AVLTree<int, int> avl;
+      for (int i = 0; i < 1000; i++)
+         avl.insert(i, i * 2);
+      int range = avl.remove_range(100, 399);
+      int batch = avl.remove_batch({0, 2, 2, 150, 998, 5000});
+      if (!(range == 300 and batch == 3 and avl.count() == 697 and !avl.exists(250) and avl.exists(400) and avl.height() <= 14))
+         cerr << "Error in AVLTree: remove_range and remove_batch methods"
+              << "\n";
+      auto elements = avl.get_elements();
+      if (!(elements.size() == 697 and is_sorted(elements.begin(), elements.end()) and avl.find(500) == 1000))
+         cerr << "Error in AVLTree: remove_range and remove_batch methods - ordering"
+              << "\n";
+
+      avl.set_lazy(true, 0.5);
+      for (int i = 400; i < 600; i++)
+         avl.remove(i);
+      avl.insert(450, 1);
+      if (!(avl.count() == 498 and avl.exists(450) and !avl.exists(451) and avl.find(450) == 1 and !avl.remove(451)))
+         cerr << "Error in AVLTree: lazy removal"
+              << "\n";
+      avl.set_lazy(false);
+      if (!(avl.count() == 498 and avl.height() <= 9 and avl.get_elements().size() == 498))
+         cerr << "Error in AVLTree: lazy removal - rebuild"
+              << "\n";
+   }
+
+   // TEST 11: buffered tree against AVLTree
+   {
+      AVLTree<int, int> avl;
+      BufferedAVLTree<int, int> buf(16);
+      for (int i = 0; i < 20000; i++)
+      {
+         int key = (i * 7919) % 1000;
+         if (!avl.insert(key, 1))
+            avl[key]++;
+         buf.increment(key, 1);
+         if (i % 7 == 0)
+         {
+            avl.remove(key / 2);
+            buf.remove(key / 2);
+         }
+      }
+      buf.insert(5000, 3);
+      buf.insert(5000, 4);
+      if (!(buf.find(5000) == 3 and buf.exists(5000) and !buf.exists(-1)))
+         cerr << "Error in BufferedAVLTree: insert and find methods"
+              << "\n";
+      buf.remove(5000);
+      if (!(buf.get_elements() == avl.get_elements() and buf.count() == avl.count()))
+         cerr << "Error in BufferedAVLTree: increment and remove methods"
+              << "\n";
+      buf.compact();
+      if (!(buf.get_elements() == avl.get_elements() and buf.height() <= avl.height() + 1))
+         cerr << "Error in BufferedAVLTree: compact method"
+              << "\n";
+      BufferedAVLTree<int, int> assigned, moved, none;
+      assigned.insert(1, 1);
+      assigned = buf;
+      buf.increment(1, 5);
+      buf.remove(2);
+      moved = buf;
+      moved.flush();
+      if (!(none.empty() and !assigned.empty() and assigned.count() == avl.count() and assigned.get_elements() == avl.get_elements() and
+            moved.count() == buf.count() and moved.get_elements() == buf.get_elements()))
+         cerr << "Error in BufferedAVLTree: count, empty and assignment"
+              << "\n";
+      moved = std::move(assigned);
+      if (!(moved.count() == avl.count() and assigned.empty()))
+         cerr << "Error in BufferedAVLTree: move assignment"
+              << "\n";
+      BufferedAVLTree<int, int> queued;
+      queued.increment(3, 1);
+      queued.insert(3, 5);
+      queued.remove(3);
+      bool none_left = queued.empty() and queued.count() == 0;
+      queued.increment(4, 2);
+      queued.increment(4, 2);
+      if (!(none_left and !queued.empty() and queued.count() == 1 and queued.exists(4) and queued.find(4) == 4 and !queued.exists(3)))
+         cerr << "Error in BufferedAVLTree: count and empty with pending messages"
+              << "\n";
+
+      vector<int> keys;
+      for (int i = 0; i < 2000000; i++)
+         keys.push_back((i * 2654435761u) % 100000 % (1 + i % 1000));
+      AVLTree<int, int> counts;
+      BufferedAVLTree<int, int> buffered;
+      auto start_avl = chrono::high_resolution_clock::now();
+      for (int key : keys)
+         if (!counts.insert(key, 1))
+            counts[key]++;
+      auto stop_avl = chrono::high_resolution_clock::now();
+      for (int key : keys)
+         buffered.increment(key, 1);
+      buffered.flush();
+      auto stop_buf = chrono::high_resolution_clock::now();
+      if (counts.get_elements() != buffered.get_elements())
+         cerr << "Error in BufferedAVLTree: ingestion"
+              << "\n";
+      cout << "Ingest: " << keys.size() << " Time(AVL): " << chrono::duration_cast<chrono::milliseconds>(stop_avl - start_avl).count()
+           << " Time(Buffered): " << chrono::duration_cast<chrono::milliseconds>(stop_buf - stop_avl).count() << endl;
+   }
+
+   // TEST 12: sharded map with concurrent writers
+   {
+      ShardedAVLMap<int, int, 8> map;
+      vector<thread> writers;
+      for (int t = 0; t < 8; t++)
+         writers.emplace_back([&map, t]()
+                              {
+                                 for (int i = 0; i < 20000; i++)
+                                    map.upsert((i * (t + 1)) % 5000, 1); });
+      for (auto &writer : writers)
+         writer.join();
+      auto elements = map.get_elements();
+      int total = 0;
+      for (auto ele : elements)
+         total += ele.second;
+      if (!(total == 160000 and map.count() == 5000 and elements.size() == 5000 and is_sorted(elements.begin(), elements.end())))
+         cerr << "Error in ShardedAVLMap: upsert method and ordered iteration"
+              << "\n";
+      map.remove(0);
+      if (!(!map.exists(0) and map.find(1) == elements[1].second and map.count() == 4999))
+         cerr << "Error in ShardedAVLMap: find, exists and remove methods"
+              << "\n";
+   }
+
+   // TEST 13: lock-free readers during updates
+   {
+      RCUAVLTree<int, int> rcu;
+      for (int i = 0; i < 1000; i += 2)
+         rcu.insert(i, i);
+      atomic<bool> stop(false);
+      atomic<int> misses(0);
+      vector<thread> readers;
+      for (int t = 0; t < 4; t++)
+         readers.emplace_back([&]()
+                              {
+                                 while (!stop)
+                                    for (int i = 0; i < 1000; i += 2)
+                                       if (!rcu.exists(i) or rcu.find(i) != i)
+                                          misses++; });
+      for (int i = 0; i < 20000; i++)
+      {
+         int key = (i * 7919) % 1000 | 1;
+         if (i % 3)
+            rcu.insert(key, key);
+         else
+            rcu.remove(key);
+      }
+      stop = true;
+      for (auto &reader : readers)
+         reader.join();
+      auto elements = rcu.get_elements();
+      if (!(misses == 0 and rcu.count() == int(elements.size()) and is_sorted(elements.begin(), elements.end()) and rcu.height() <= 12))
+         cerr << "Error in RCUAVLTree: concurrent readers"
+              << "\n";
+      rcu.modify(0, -1);
+      rcu.clear();
+      if (!(rcu.empty() and !rcu.exists(0)))
+         cerr << "Error in RCUAVLTree: modify and clear methods"
+              << "\n";
+   }
+
+   // TEST 14: concurrent writers with optimistic validation
+   {
+      ConcurrentAVLTree<int, int> tree;
+      vector<thread> writers;
+      for (int t = 0; t < 8; t++)
+         writers.emplace_back([&tree, t]()
+                              {
+                                 for (int i = t; i < 40000; i += 8)
+                                    tree.insert(i, i);
+                                 for (int i = t; i < 40000; i += 16)
+                                    tree.remove(i); });
+      for (auto &writer : writers)
+         writer.join();
+      auto elements = tree.get_elements();
+      bool survivors = true;
+      for (auto ele : elements)
+         survivors = survivors and ele.first % 16 >= 8 and ele.second == ele.first;
+      if (!(survivors and tree.count() == 20000 and elements.size() == 20000 and is_sorted(elements.begin(), elements.end()) and tree.height() <= 20))
+         cerr << "Error in ConcurrentAVLTree: concurrent insert and remove methods"
+              << "\n";
+      tree.assign(1, -1);
+      if (!(tree.find(1) == -1 and !tree.exists(0) and !tree.insert(1, 1) and tree.remove(1) and !tree.remove(1)))
+         cerr << "Error in ConcurrentAVLTree: assign, find and exists methods"
+              << "\n";
+      tree.clear();
+      if (!(tree.empty() and tree.height() == -1))
+         cerr << "Error in ConcurrentAVLTree: clear method"
+              << "\n";
+
+      // mixed workload: 50% find, 25% insert, 25% remove over 100000 keys
+      const int ops = 400000;
+      for (int threads : {1, 2, 4, 8, 16})
+      {
+         ConcurrentAVLTree<int, int> concurrent;
+         AVLTree<int, int> locked;
+         mutex lock;
+         for (int i = 0; i < 100000; i += 2)
+         {
+            concurrent.insert(i, i);
+            locked.insert(i, i);
+         }
+         auto mixed = [&](bool fine, int t)
+         {
+            unsigned key = t;
+            for (int i = 0; i < ops / threads; i++)
+            {
+               key = key * 1664525 + 1013904223;
+               int k = (key >> 8) % 100000;
+               if (fine)
+               {
+                  if (key % 4 < 2)
+                     concurrent.exists(k);
+                  else if (key % 4 == 2)
+                     concurrent.insert(k, k);
+                  else
+                     concurrent.remove(k);
+               }
+               else
+               {
+                  lock_guard<mutex> guard(lock);
+                  if (key % 4 < 2)
+                     locked.exists(k);
+                  else if (key % 4 == 2)
+                     locked.insert(k, k);
+                  else
+                     locked.remove(k);
+               }
+            }
+         };
+         chrono::high_resolution_clock::duration time[2];
+         for (int fine = 0; fine < 2; fine++)
+         {
+            vector<thread> workers;
+            auto start = chrono::high_resolution_clock::now();
+            for (int t = 0; t < threads; t++)
+               workers.emplace_back(mixed, fine, t);
+            for (auto &worker : workers)
+               worker.join();
+            time[fine] = chrono::high_resolution_clock::now() - start;
+         }
+         auto throughput = [&](int fine)
+         { return ops / (chrono::duration<double>(time[fine]).count() * 1e6); };
+         cout << "Threads: " << threads << " Mops/s(Locked AVL): " << throughput(0) << " Mops/s(Concurrent AVL): " << throughput(1) << endl;
+      }
+   }
+
+   // TEST 15: B+tree against AVLTree
+   {
+      AVLTree<int, int> avl;
+      BPlusTree<int, int, 8> bpt;
+      for (int i = 0; i < 20000; i++)
+      {
+         int key = (i * 7919) % 5000;
+         if (i % 3)
+         {
+            avl.insert(key, i);
+            bpt.insert(key, i);
+         }
+         else
+         {
+            avl.remove(key / 2);
+            bpt.remove(key / 2);
+         }
+      }
+      if (!(bpt.get_elements() == avl.get_elements() and bpt.count() == avl.count() and bpt.height() <= 6))
+         cerr << "Error in BPlusTree: insert and remove methods"
+              << "\n";
+      bpt[4999] = -1;
+      auto range = bpt.get_elements(100, 199);
+      if (!(bpt.find(4999) == -1 and bpt.exists(4999) and !bpt.exists(5000) and range.size() <= 100 and is_sorted(range.begin(), range.end())))
+         cerr << "Error in BPlusTree: find and range methods"
+              << "\n";
+      BPlusTree<int, int, 8> copy(bpt);
+      for (auto ele : bpt.get_elements())
+         bpt.remove(ele.first);
+      if (!(bpt.empty() and bpt.height() == -1 and copy.count() == avl.count()))
+         cerr << "Error in BPlusTree: remove all and copy constructor"
+              << "\n";
+
+      // lookups of random keys, half of them missing; BinarySearchTree::find visits
+      // the whole tree, so it only takes part at the smallest size
+      for (int n : {10000, 100000, 1000000})
+      {
+         AVLTree<int, int> avl_keys;
+         BinarySearchTree<int, int> bst_keys;
+         BPlusTree<int, int> bpt_keys;
+         vector<int> probes;
+         unsigned key = 1;
+         for (int i = 0; i < n; i++)
+         {
+            key = key * 1664525 + 1013904223;
+            avl_keys.insert(key >> 1 & ~1, i);
+            if (n <= 10000)
+               bst_keys.insert(key >> 1 & ~1, i);
+            bpt_keys.insert(key >> 1 & ~1, i);
+            probes.push_back(key >> 1 ^ (i & 1));
+         }
+         int found[3] = {0, 0, 0};
+         auto start = chrono::high_resolution_clock::now();
+         for (int probe : probes)
+            found[0] += avl_keys.exists(probe);
+         auto stop_avl = chrono::high_resolution_clock::now();
+         for (int probe : probes)
+            if (n <= 10000)
+               found[1] += bst_keys.exists(probe);
+         auto stop_bst = chrono::high_resolution_clock::now();
+         for (int probe : probes)
+            found[2] += bpt_keys.exists(probe);
+         auto stop_bpt = chrono::high_resolution_clock::now();
+         if (!(found[0] == found[2] and (n > 10000 or found[1] == found[2])))
+            cerr << "Error in BPlusTree: lookups"
+                 << "\n";
+         // the number found is printed so that no lookup loop can be dropped as unused
+         cout << "Lookups: " << n << " Time(AVL): " << chrono::duration_cast<chrono::microseconds>(stop_avl - start).count()
+              << " Time(BST): " << (n <= 10000 ? to_string(chrono::duration_cast<chrono::microseconds>(stop_bst - stop_avl).count()) : "-")
+              << " Time(B+): " << chrono::duration_cast<chrono::microseconds>(stop_bpt - stop_bst).count()
+              << " Found: " << found[0] + found[1] + found[2] << endl;
+      }
+   }
+
+   // TEST 16: paged tree with a small buffer pool
+   {
+      AVLTree<int, int> avl;
+      {
+         PagedAVLTree<int, int> paged("paged_avl.db", 8);
+         for (int i = 0; i < 50000; i++)
+         {
+            int key = (i * 7919) % 20000;
+            if (i % 4)
+            {
+               avl.insert(key, i);
+               paged.insert(key, i);
+            }
+            else
+            {
+               avl.remove(key / 3);
+               paged.remove(key / 3);
+            }
+         }
+         if (!(paged.get_elements() == avl.get_elements() and paged.count() == avl.count() and paged.height() == avl.height()))
+            cerr << "Error in PagedAVLTree: insert and remove methods"
+                 << "\n";
+         cout << "Paged: " << paged.count() << " Hits: " << paged.hits() << " Misses: " << paged.misses() << endl;
+      }
+      {
+         PagedAVLTree<int, int> paged("paged_avl.db", 8);
+         int key = avl.get_elements().back().first;
+         paged.update(key, -1);
+         if (!(paged.count() == avl.count() and paged.find(key) == -1 and !paged.exists(20000)))
+            cerr << "Error in PagedAVLTree: reopening the file"
+                 << "\n";
+         paged.clear();
+         paged.insert(1, 1);
+         if (!(paged.count() == 1 and paged.get_elements().size() == 1))
+            cerr << "Error in PagedAVLTree: clear method"
+                 << "\n";
+      }
+      remove("paged_avl.db");
+      {
+         PagedAVLTree<FixedKey<16>, int> words("paged_avl.db", 8);
+         words.insert(string("beagle"), 1);
+         if (!(words.find(string("beagle")) == 1 and !words.exists(string("voyage"))))
+            cerr << "Error in PagedAVLTree: fixed-size string keys"
+                 << "\n";
+      }
+      remove("paged_avl.db");
+   }
+
+   // TEST 17: deferred clear, swap and assignment
+   {
+      AVLTree<int, int> avl1 = vec2avl<int, int>({{1, 1}, {2, 2}, {3, 3}}), avl2;
+      avl2 = avl1;
+      avl1.clear();
+      avl1.swap(avl2);
+      if (!(avl1.count() == 3 and avl2.empty() and avl1.find(2) == 2))
+         cerr << "Error in AVLTree: assignment operator and swap method"
+              << "\n";
+      avl2.set_deferred_clear(true);
+      avl2 = vec2avl<int, int>({{4, 4}});
+      avl2 = std::move(avl1);
+      if (!(avl2.count() == 3 and avl1.empty() and !avl2.exists(4)))
+         cerr << "Error in AVLTree: move assignment operator"
+              << "\n";
+
+      AVLTree<int, int> sync, deferred;
+      deferred.set_deferred_clear(true);
+      for (int i = 0; i < 1000000; i++)
+      {
+         sync.insert(i, i);
+         deferred.insert(i, i);
+      }
+      auto start = chrono::high_resolution_clock::now();
+      sync.clear();
+      auto stop_sync = chrono::high_resolution_clock::now();
+      deferred.clear();
+      auto stop_deferred = chrono::high_resolution_clock::now();
+      Reclaimer::instance().wait();
+      if (!(deferred.empty() and Reclaimer::instance().pending() == 0))
+         cerr << "Error in AVLTree: deferred clear"
+              << "\n";
+      cout << "Clear: 1000000 Time(sync): " << chrono::duration_cast<chrono::microseconds>(stop_sync - start).count()
+           << " Time(deferred): " << chrono::duration_cast<chrono::microseconds>(stop_deferred - stop_sync).count() << endl;
+   }
+
+   // TEST 18: negative-lookup filter
+   {
+      AVLTree<int, int> plain, filtered;
+      filtered.enable_filter();
+      for (int i = 0; i < 1000000; i += 2)
+      {
+         plain.insert(i * 7, i);
+         filtered.insert(i * 7, i);
+      }
+      filtered.remove_range(0, 6999);
+      plain.remove_range(0, 6999);
+      filtered.remove(7000);
+      plain.remove(7000);
+      bool agree = filtered.count() == plain.count() and filtered.try_find(14) == nullptr and *filtered.try_find(7014) == 1002;
+      for (int i = 0; i < 100000 and agree; i++)
+         agree = filtered.exists(i) == plain.exists(i);
+      if (!agree)
+         cerr << "Error in AVLTree: filter maintenance"
+              << "\n";
+
+      // stored keys are multiples of 14, so nine probes in ten miss
+      int found[2] = {0, 0};
+      auto start = chrono::high_resolution_clock::now();
+      for (int i = 0; i < 2000000; i++)
+         found[0] += plain.exists(i * 2654435761u % 500000 * 14 + (i % 10 != 0));
+      auto stop_plain = chrono::high_resolution_clock::now();
+      for (int i = 0; i < 2000000; i++)
+         found[1] += filtered.exists(i * 2654435761u % 500000 * 14 + (i % 10 != 0));
+      auto stop_filtered = chrono::high_resolution_clock::now();
+      if (found[0] != found[1])
+         cerr << "Error in AVLTree: filtered lookups"
+              << "\n";
+      // copies keep the filter, and trees over keys without std::hash still copy
+      AVLTree<int, int> copied(filtered);
+      AVLTree<Point, int> points, assigned;
+      points.insert(Point{1, 2}, 3);
+      AVLTree<Point, int> points_copy(points);
+      assigned = points;
+      if (copied.count() != filtered.count() or copied.exists(14) or !copied.exists(7014) or
+          points_copy.find(Point{1, 2}) != 3 or assigned.find(Point{1, 2}) != 3)
+         cerr << "Error in AVLTree: copies of filtered and unhashable trees"
+              << "\n";
+      cout << "Probes: 2000000 Time(AVL): " << chrono::duration_cast<chrono::milliseconds>(stop_plain - start).count()
+           << " Time(filtered AVL): " << chrono::duration_cast<chrono::milliseconds>(stop_filtered - stop_plain).count() << endl;
+   }
+
+   // TEST 19: front cache for skewed lookups
+   {
+      AVLTree<int, int> avl;
+      avl.enable_cache(64);
+      for (int i = 0; i < 100; i++)
+         avl.insert(i, i);
+      for (int i = 0; i < 100; i++)
+         avl.exists(i % 4);
+      avl.remove(2);
+      avl.remove_range(50, 59);
+      avl.set_lazy(true);
+      avl.remove(1);
+      if (!(!avl.exists(2) and !avl.exists(1) and !avl.exists(55) and avl.find(3) == 3 and avl.cache_hits() >= 90))
+         cerr << "Error in AVLTree: cache invalidation"
+              << "\n";
+      avl.clear();
+      if (!(!avl.exists(3) and avl.try_find(0) == nullptr))
+         cerr << "Error in AVLTree: cache after clear"
+              << "\n";
+
+      // word frequencies of real text are Zipf-distributed
+      vector<string> words;
+      ifstream file("TheVoyageoftheBeagle.txt");
+      string word;
+      while (file >> word)
+         words.push_back(word);
+      for (size_t i = 0, n = words.size(); i < 9 * n; i++)
+         words.push_back(words[i]);
+      AVLTree<string, int> plain, cached;
+      cached.enable_cache(1024);
+      auto count = [&words](AVLTree<string, int> &dict)
+      {
+         for (const string &word : words)
+         {
+            int *counter = dict.try_find(word);
+            if (counter)
+               (*counter)++;
+            else
+               dict.insert(word, 1);
+         }
+      };
+      auto start = chrono::high_resolution_clock::now();
+      count(plain);
+      auto stop_plain = chrono::high_resolution_clock::now();
+      count(cached);
+      auto stop_cached = chrono::high_resolution_clock::now();
+      if (plain.get_elements() != cached.get_elements())
+         cerr << "Error in AVLTree: cached counting"
+              << "\n";
+      cout << "Words: " << words.size() << " Time(AVL): " << chrono::duration_cast<chrono::milliseconds>(stop_plain - start).count()
+           << " Time(cached AVL): " << chrono::duration_cast<chrono::milliseconds>(stop_cached - stop_plain).count()
+           << " Hit rate: " << 100 * cached.cache_hits() / (cached.cache_hits() + cached.cache_misses()) << "%" << endl;
+   }
+
+   // TEST 20: streaming word count
+   {
+      AVLTree<string, int> batch = counter("TheVoyageoftheBeagle.txt");
+      ifstream file("TheVoyageoftheBeagle.txt");
+      string text((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+      // the text goes through a pipe in pieces that split words
+      int fds[2];
+      if (pipe(fds) != 0)
+         cerr << "Error in stream_counter: pipe"
+              << "\n";
+      thread writer([&text, &fds]()
+                    {
+         for (size_t i = 0; i < text.size(); i += 1000)
+         {
+            size_t piece = min<size_t>(1000, text.size() - i);
+            if (write(fds[1], text.data() + i, piece) != ssize_t(piece))
+               break;
+            if (i % 100000 == 0)
+               this_thread::sleep_for(chrono::milliseconds(2));
+         }
+         close(fds[1]); });
+      AVLTree<string, int> streamed;
+      StreamOptions options;
+      options.interval = chrono::milliseconds(1);
+      options.top = 3;
+      options.chunk = 4096;
+      int snapshots = 0;
+      vector<pair<string, int>> last;
+      options.emit = [&snapshots, &last](const vector<pair<string, int>> &words)
+      {
+         snapshots++;
+         last = words;
+      };
+      stream_counter(fds[0], streamed, options);
+      writer.join();
+      close(fds[0]);
+      if (!(streamed.get_elements() == batch.get_elements() and snapshots >= 2))
+         cerr << "Error in stream_counter: counts"
+              << "\n";
+      if (!(last.size() == 3 and last[0] == make_pair(string("the"), 16924) and last[1].first == "of" and last[2].first == "and"))
+         cerr << "Error in stream_counter: top words"
+              << "\n";
+
+      // following an idle input ends when the stop flag is set
+      if (pipe(fds) != 0)
+         cerr << "Error in stream_counter: pipe"
+              << "\n";
+      atomic<bool> stop(false);
+      options.follow = true;
+      options.stop = &stop;
+      AVLTree<string, int> followed;
+      thread feeder([&fds, &stop]()
+                    {
+         if (write(fds[1], "a b a", 5) != 5)
+            return;
+         this_thread::sleep_for(chrono::milliseconds(50));
+         stop = true; });
+      stream_counter(fds[0], followed, options);
+      feeder.join();
+      close(fds[0]);
+      close(fds[1]);
+      if (!(followed.count() == 2 and followed.find("a") == 2 and last.size() == 2))
+         cerr << "Error in stream_counter: stop"
+              << "\n";
+   }
+
+   // TEST 21: checkpoints of the count dictionary
+   {
+      remove("counts.ckpt");
+      remove("counts.ckpt.log");
+      vector<string> words;
+      ifstream file("TheVoyageoftheBeagle.txt");
+      string word;
+      while (file >> word)
+         words.push_back(word);
+      AVLTree<string, int> dict, expected;
+      size_t batches;
+      {
+         CountCheckpoint checkpoint("counts.ckpt");
+         checkpoint.recover(dict);
+         for (size_t i = 0; i < words.size(); i++)
+         {
+            count_word(dict, words[i]);
+            checkpoint.record(words[i]);
+            if (i == 100000)
+               checkpoint.snapshot(dict, i + 1);
+            else if (i % 20000 == 0)
+               checkpoint.sync(i + 1);
+         }
+         checkpoint.sync(words.size());
+         expected = dict;
+         // lost like in a crash, since it is never synced
+         count_word(dict, "unsynced");
+         checkpoint.record("unsynced");
+      }
+      {
+         CountCheckpoint checkpoint("counts.ckpt");
+         batches = checkpoint.recover(dict);
+         if (!(dict.get_elements() == expected.get_elements() and checkpoint.generation() == 1 and
+               checkpoint.position() == words.size() and batches == 6))
+            cerr << "Error in CountCheckpoint: recover"
+                 << "\n";
+      }
+
+      // a batch torn by a crash is dropped, and the log grows on from before it
+      {
+         ofstream torn("counts.ckpt.log", ios::app | ios::binary);
+         torn << "\x05\x00\x00\x00garbage";
+      }
+      {
+         CountCheckpoint checkpoint("counts.ckpt");
+         if (!(checkpoint.recover(dict) == batches and dict.get_elements() == expected.get_elements()))
+            cerr << "Error in CountCheckpoint: torn log"
+                 << "\n";
+         count_word(expected, "the");
+         checkpoint.record("the");
+         checkpoint.sync(words.size() + 4);
+      }
+      {
+         CountCheckpoint checkpoint("counts.ckpt");
+         if (!(checkpoint.recover(dict) == batches + 1 and dict.get_elements() == expected.get_elements() and
+               checkpoint.position() == words.size() + 4))
+            cerr << "Error in CountCheckpoint: append after torn log"
+                 << "\n";
+      }
+
+      // a log left behind by a crash right after a snapshot is not replayed again
+      {
+         ifstream old_log("counts.ckpt.log", ios::binary);
+         string stale((istreambuf_iterator<char>(old_log)), istreambuf_iterator<char>());
+         CountCheckpoint checkpoint("counts.ckpt");
+         checkpoint.recover(dict);
+         checkpoint.snapshot(dict, checkpoint.position());
+         ofstream("counts.ckpt.log", ios::binary) << stale;
+      }
+      {
+         CountCheckpoint checkpoint("counts.ckpt");
+         if (!(checkpoint.recover(dict) == 0 and dict.get_elements() == expected.get_elements() and checkpoint.generation() == 2))
+            cerr << "Error in CountCheckpoint: stale log"
+                 << "\n";
+      }
+      remove("counts.ckpt");
+      remove("counts.ckpt.log");
+
+      // a stream restarted from its checkpoint ends with the counts of one full pass
+      AVLTree<string, int> batch = counter("TheVoyageoftheBeagle.txt");
+      size_t first_part;
+      {
+         CountCheckpoint checkpoint("counts.ckpt");
+         AVLTree<string, int> streamed;
+         checkpoint.recover(streamed);
+         int fd = open("TheVoyageoftheBeagle.txt", O_RDONLY);
+         atomic<bool> stop(false);
+         StreamOptions options;
+         options.interval = chrono::milliseconds(1);
+         options.snapshot_every = 3;
+         options.chunk = 4096;
+         options.checkpoint = &checkpoint;
+         options.stop = &stop;
+         options.emit = [&stop](const vector<pair<string, int>> &)
+         { stop = true; };
+         stream_counter(fd, streamed, options);
+         close(fd);
+         first_part = checkpoint.position();
+      }
+      {
+         CountCheckpoint checkpoint("counts.ckpt");
+         AVLTree<string, int> streamed;
+         checkpoint.recover(streamed);
+         int fd = open("TheVoyageoftheBeagle.txt", O_RDONLY);
+         lseek(fd, checkpoint.position(), SEEK_SET);
+         StreamOptions options;
+         options.checkpoint = &checkpoint;
+         options.emit = [](const vector<pair<string, int>> &) {};
+         stream_counter(fd, streamed, options);
+         close(fd);
+         if (!(streamed.get_elements() == batch.get_elements() and first_part > 0))
+            cerr << "Error in stream_counter: restart from checkpoint"
+                 << "\n";
+      }
+      remove("counts.ckpt");
+      remove("counts.ckpt.log");
+   }
+
+   // TEST 22: compile-time dictionaries
+   {
+      constexpr pair<string_view, int> stop_words[] = {{"the", 1}, {"of", 2}, {"and", 3}, {"a", 4}, {"to", 5}, {"in", 6}, {"is", 7}, {"that", 8}, {"it", 9}, {"was", 10}, {"on", 11}, {"with", 12}, {"as", 13}, {"by", 14}, {"at", 15}, {"from", 16}, {"this", 17}, {"which", 18}, {"be", 19}, {"the", 20}, {"are", 21}, {"an", 22}};
+      constexpr auto table = make_static_avl(stop_words);
+      static_assert(table.count() == 21 and table.height() == 4, "Error in StaticAVL: layout");
+      static_assert(table.find("the") == 1 and table["are"] == 21 and table.exists("an"), "Error in StaticAVL: find");
+      static_assert(!table.exists("beagle") and table.try_find("") == nullptr and !table.exists("zzz"), "Error in StaticAVL: missing keys");
+      constexpr auto empty = make_static_avl<int, int>({{1, 1}});
+      static_assert(empty.count() == 1 and empty.height() == 0 and empty.find(1) == 1 and !empty.exists(2), "Error in StaticAVL: single element");
+
+      AVLTree<string_view, int> avl;
+      for (auto ele : stop_words)
+         avl.insert(ele.first, ele.second);
+      if (!(table.get_elements() == avl.get_elements() and table.height() <= avl.height()))
+         cerr << "Error in StaticAVL: differs from AVLTree"
+              << "\n";
+      try
+      {
+         table.find("beagle");
+         cerr << "Error in StaticAVL: find of a missing key"
+              << "\n";
+      }
+      catch (const char *msg)
+      {
+      }
+   }
+
+   // TEST 23: buffered export
+   {
+      AVLTree<string, int> avl;
+      avl.insert("plain", 1);
+      avl.insert("with,comma", -20);
+      avl.insert("say \"hi\"", 300);
+      avl.insert("tab\there", 4000);
+      auto exported = [&avl](Format format)
+      {
+         int fd = open("export.out", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+         avl.export_elements(fd, format);
+         close(fd);
+         ifstream file("export.out", ios::binary);
+         return string((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+      };
+      if (exported(Format::CSV) != "plain,1\n\"say \"\"hi\"\"\",300\ntab\there,4000\n\"with,comma\",-20\n")
+         cerr << "Error in export: CSV"
+              << "\n";
+      if (exported(Format::TSV) != "plain\t1\nsay \"hi\"\t300\ntab\\there\t4000\nwith,comma\t-20\n")
+         cerr << "Error in export: TSV"
+              << "\n";
+      if (exported(Format::JSONLines) != "{\"key\":\"plain\",\"info\":1}\n{\"key\":\"say \\\"hi\\\"\",\"info\":300}\n"
+                                         "{\"key\":\"tab\\u0009here\",\"info\":4000}\n{\"key\":\"with,comma\",\"info\":-20}\n")
+         cerr << "Error in export: JSON lines"
+              << "\n";
+      string dump = exported(Format::Binary);
+      vector<pair<string, int>> loaded;
+      for (size_t at = 0; at + 4 <= dump.size();)
+      {
+         uint32_t length;
+         int info;
+         memcpy(&length, &dump[at], 4);
+         string key = dump.substr(at + 4, length);
+         memcpy(&info, &dump[at + 4 + length], 4);
+         loaded.emplace_back(key, info);
+         at += 8 + length;
+      }
+      if (loaded != avl.get_elements())
+         cerr << "Error in export: binary"
+              << "\n";
+
+      AVLTree<int, double> large;
+      for (int i = 0; i < 1000000; i++)
+         large.insert(int(i * 7919LL % 1000000), i / 8.0);
+      auto start = chrono::high_resolution_clock::now();
+      {
+         ofstream file("export.out");
+         for (auto &ele : large.get_elements())
+            file << ele.first << "," << ele.second << "\n";
+      }
+      auto stop_stream = chrono::high_resolution_clock::now();
+      int fd = open("export.out", O_WRONLY | O_TRUNC);
+      large.export_elements(fd, Format::CSV);
+      close(fd);
+      auto stop_export = chrono::high_resolution_clock::now();
+      remove("export.out");
+      cout << "Export: " << large.count() << " Time(ostream): " << chrono::duration_cast<chrono::milliseconds>(stop_stream - start).count()
+           << " Time(OutputBuffer): " << chrono::duration_cast<chrono::milliseconds>(stop_export - stop_stream).count() << endl;
+   }
+
+   // TEST 24: non-throwing lookups
+   {
+      AVLTree<int, int> avl;
+      BinarySearchTree<int, int> bst;
+      BPlusTree<int, int> bpt;
+      BufferedAVLTree<int, int> buf;
+      ConcurrentAVLTree<int, int> concurrent;
+      RCUAVLTree<int, int> rcu;
+      ShardedAVLMap<int, int, 4> map;
+      for (int i = 0; i < 100; i += 2)
+      {
+         avl.insert(i, i * 3);
+         bst.insert(i, i * 3);
+         bpt.insert(i, i * 3);
+         buf.insert(i, i * 3);
+         concurrent.insert(i, i * 3);
+         rcu.insert(i, i * 3);
+         map.insert(i, i * 3);
+      }
+      bool hits = *avl.try_find(10) == 30 and *bst.try_find(10) == 30 and *bpt.try_find(10) == 30 and *buf.try_find(10) == 30 and
+                  *concurrent.try_find(10) == 30 and *rcu.try_find(10) == 30 and *map.try_find(10) == 30;
+      bool misses = !avl.try_find(11) and !bst.try_find(11) and !bpt.try_find(11) and !buf.try_find(11) and
+                    !concurrent.try_find(11) and !rcu.try_find(11) and !map.try_find(11);
+      bool fallbacks = avl.find_or(11, -1) == -1 and bst.find_or(11, -1) == -1 and bpt.find_or(98, -1) == 294 and buf.find_or(11, -1) == -1 and
+                       concurrent.find_or(11, -1) == -1 and rcu.find_or(12, -1) == 36 and map.find_or(11, -1) == -1;
+      if (!(hits and misses and fallbacks))
+         cerr << "Error in try_find and find_or methods"
+              << "\n";
+
+      // misses are the common case of a lookup-heavy loop
+      int found = 0;
+      auto start = chrono::high_resolution_clock::now();
+      for (int i = 0; i < 100000; i++)
+         try
+         {
+            found += avl.find(i % 200) != 0;
+         }
+         catch (const char *msg)
+         {
+         }
+      auto stop_throwing = chrono::high_resolution_clock::now();
+      for (int i = 0; i < 100000; i++)
+         found += avl.find_or(i % 200, 0) != 0;
+      auto stop_find_or = chrono::high_resolution_clock::now();
+      if (found != 2 * 49 * 500)
+         cerr << "Error in find_or method: misses"
+              << "\n";
+      cout << "Misses: 75000 Time(find): " << chrono::duration_cast<chrono::microseconds>(stop_throwing - start).count()
+           << " Time(find_or): " << chrono::duration_cast<chrono::microseconds>(stop_find_or - stop_throwing).count() << endl;
+   }
+
    // TEST 9: computational complexity
    {
       AVLTree<int, int> avl;
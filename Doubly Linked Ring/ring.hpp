@@ -133,16 +133,20 @@ public:
                return *this;
           }
 
+          Element &get() const // unchecked dereference, for loops known to stay on elements
+          {
+               return *(node->element);
+          }
           Element &operator*() // dereference operator
           {
                if (node)
-                    return *(node->element);
+                    return get();
                throw std::runtime_error("Iterator points to nullptr");
           }
           Element *operator->() // arrow operator
           {
                if (node)
-                    return node->element;
+                    return &get();
                throw std::runtime_error("Iterator points to nullptr");
           }
      };
@@ -246,10 +250,14 @@ public:
                return *this;
           }
 
+          const Element &get() const // unchecked dereference, for loops known to stay on elements
+          {
+               return *(node->element);
+          }
           const Element &operator*() const // dereference operator
           {
                if (node)
-                    return *(node->element);
+                    return get();
                throw std::runtime_error("Iterator points to nullptr");
           }
           Element *operator->() const // arrow operator
@@ -426,6 +434,19 @@ public:
      {
           return len;
      }
+     Info *try_find(const Key &key, unsigned int occur = 1) const // returns a pointer to the info of the occur-th element with the given key, or nullptr if there is none
+     {
+          Node *node = head;
+          for (unsigned int i = 0; i < len; i++, node = node->next)
+               if (node->element->key == key and --occur == 0)
+                    return &node->element->info;
+          return nullptr;
+     }
+     Info find_or(const Key &key, const Info &fallback, unsigned int occur = 1) const // returns the info of the occur-th element with the given key, or fallback if there is none
+     {
+          Info *info = try_find(key, occur);
+          return info ? *info : fallback;
+     }
      void clear() // removes all the elements of the bi_ring
      {
           while (!empty())
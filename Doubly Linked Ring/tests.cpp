@@ -171,5 +171,21 @@ int main()
           if (result != bi_ring<string, int>{{"uno", 1}, {"bir", 1}, {"iki", 2}, {"due", 2}, {"uc", 3}, {"dort", 4}, {"tre", 3}, {"bes", 5}, {"bir", 1}})
                cerr << "Error in shuffle method\n";
      }
+
+     // TEST 17 try_find, find_or and unchecked iteration
+     {
+          bi_ring<string, int> br1{{"uno", 1}, {"due", 2}, {"uno", 3}};
+          int *second = br1.try_find("uno", 2);
+          if (!second or *second != 3 or br1.try_find("tre") or br1.try_find("uno", 3) or bi_ring<string, int>().try_find("uno"))
+               cerr << "Error in try_find method\n";
+          if (br1.find_or("due", 0) != 2 or br1.find_or("tre", -1) != -1)
+               cerr << "Error in find_or method\n";
+          int sum = 0;
+          auto it = br1.begin();
+          for (unsigned int i = 0; i < br1.size(); i++, it++)
+               sum += it.get().info;
+          if (sum != 6)
+               cerr << "Error in iterator get method\n";
+     }
      cout << "End of tests\n";
 }
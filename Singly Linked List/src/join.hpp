@@ -0,0 +1,181 @@
+#pragma once
+#include "sequence.hpp"
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <cstddef>
+#include <memory>
+
+//adds the infos of matching keys; concatenates strings
+struct SumAggregate
+{
+    template <typename Info>
+    Info operator()(const Info &left, const Info &right) const
+    {
+        return left + right;
+    }
+};
+
+//keeps the larger of the infos of matching keys
+struct MaxAggregate
+{
+    template <typename Info>
+    Info operator()(const Info &left, const Info &right) const
+    {
+        return left < right ? right : left;
+    }
+};
+
+//positional join: walks both sequences once; where the elements at the same index have
+//equal keys they are merged into one with aggregate(left info, right info), otherwise the
+//left element is followed by the right one; the rest of the longer sequence is appended;
+//aggregate can be any callable, so it is inlined
+template <typename Key, typename Info, typename Alloc, typename Aggregate>
+Sequence<Key, Info, Alloc> join(const Sequence<Key, Info, Alloc> &left, const Sequence<Key, Info, Alloc> &right, Aggregate aggregate)
+{
+    Sequence<Key, Info, Alloc> result(left.get_allocator());
+
+    auto lit = left.begin();
+    auto rit = right.begin();
+    while ((lit != left.end()) and (rit != right.end()))
+    {
+        if (lit->get_key() == rit->get_key())
+        {
+            result.emplace_back(lit->get_key(), aggregate(lit->get_info(), rit->get_info()));
+        }
+        else
+        {
+            result.push_back(lit->get_key(), lit->get_info());
+            result.push_back(rit->get_key(), rit->get_info());
+        }
+        ++lit;
+        ++rit;
+    }
+    for (; lit != left.end(); ++lit)
+    {
+        result.push_back(lit->get_key(), lit->get_info());
+    }
+    for (; rit != right.end(); ++rit)
+    {
+        result.push_back(rit->get_key(), rit->get_info());
+    }
+    return result;
+}
+
+//overload for function pointers, so that the address of a function template can be passed
+template <typename Key, typename Info, typename Alloc>
+Sequence<Key, Info, Alloc> join(const Sequence<Key, Info, Alloc> &left, const Sequence<Key, Info, Alloc> &right, Info (*aggregate)(const Info &left, const Info &right))
+{
+    return join<Key, Info, Alloc, Info (*)(const Info &, const Info &)>(left, right, aggregate);
+}
+
+//joins rows rows of count sequences from the given cursors, which are advanced past them
+template <typename Key, typename Info, typename Alloc, typename Aggregate>
+void join_rows(const Sequence<Key, Info, Alloc> *parts, std::size_t count, std::vector<typename Sequence<Key, Info, Alloc>::const_iterator> &cursors,
+               unsigned int rows, Aggregate &aggregate, Sequence<Key, Info, Alloc> &result)
+{
+    std::vector<std::pair<const Key *, Info>> row; //distinct keys of the current index in order of appearance
+    row.reserve(count);
+    for (unsigned int r = 0; r < rows; r++)
+    {
+        row.clear();
+        for (std::size_t p = 0; p < count; p++)
+        {
+            if (cursors[p] == parts[p].end())
+            {
+                continue;
+            }
+            const Node<Key, Info> &node = *cursors[p]++;
+            std::size_t i = 0;
+            while ((i < row.size()) and !(*row[i].first == node.get_key()))
+            {
+                i++;
+            }
+            if (i < row.size())
+            {
+                row[i].second = aggregate(row[i].second, node.get_info());
+            }
+            else
+            {
+                row.emplace_back(&node.get_key(), node.get_info());
+            }
+        }
+        for (auto &element : row)
+        {
+            result.emplace_back(*element.first, std::move(element.second));
+        }
+    }
+}
+
+//positional join of count sequences in one pass, with the rule of join applied to each
+//index: the elements at the index are merged per key, in order of first appearance, by
+//folding aggregate over their infos from the first sequence to the last; with two
+//sequences this is exactly join
+//
+//large inputs are split into one range of indices per thread; each range is joined on
+//its own thread into its own Sequence and the pieces are spliced together without copying,
+//so aggregate must then be safe to use from several threads at once; the pieces share the
+//allocator of the result, so allocators that are not always equal, which may hold state such
+//as a pool, keep the join on one thread
+template <typename Key, typename Info, typename Alloc, typename Aggregate>
+Sequence<Key, Info, Alloc> join_many(const Sequence<Key, Info, Alloc> *parts, std::size_t count, Aggregate aggregate, unsigned int threads = 0)
+{
+    const unsigned int min_rows = 1 << 16; //smallest range worth a thread
+    unsigned int rows = 0;
+    for (std::size_t p = 0; p < count; p++)
+    {
+        rows = std::max(rows, parts[p].size());
+    }
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, std::max(1u, rows / min_rows));
+    if (!std::allocator_traits<Alloc>::is_always_equal::value)
+    {
+        threads = 1;
+    }
+
+    //cursors[t] holds where range t starts in every sequence, found in one walk of each
+    unsigned int per_thread = (rows + threads - 1) / threads;
+    std::vector<std::vector<typename Sequence<Key, Info, Alloc>::const_iterator>> cursors(threads);
+    for (std::size_t p = 0; p < count; p++)
+    {
+        auto it = parts[p].begin();
+        for (unsigned int t = 0; t < threads; t++)
+        {
+            cursors[t].push_back(it);
+            for (unsigned int r = 0; (r < per_thread) and (it != parts[p].end()) and (t + 1 < threads); r++)
+            {
+                ++it;
+            }
+        }
+    }
+
+    Sequence<Key, Info, Alloc> result(count ? parts[0].get_allocator() : Alloc());
+    std::vector<Sequence<Key, Info, Alloc>> pieces(threads, result);
+    std::vector<std::thread> workers;
+    for (unsigned int t = 1; t < threads; t++)
+    {
+        unsigned int range = std::min(per_thread, rows - std::min(rows, t * per_thread));
+        workers.emplace_back([&, t, range]()
+                             { join_rows(parts, count, cursors[t], range, aggregate, pieces[t]); });
+    }
+    join_rows(parts, count, cursors[0], std::min(per_thread, rows), aggregate, pieces[0]);
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    for (auto &piece : pieces)
+    {
+        result.splice(piece);
+    }
+    return result;
+}
+
+template <typename Key, typename Info, typename Alloc, typename Aggregate>
+Sequence<Key, Info, Alloc> join_many(const std::vector<Sequence<Key, Info, Alloc>> &parts, Aggregate aggregate, unsigned int threads = 0)
+{
+    return join_many(parts.data(), parts.size(), aggregate, threads);
+}
@@ -1,40 +1,51 @@
+#pragma once
 #include <iostream>
+#include <utility>
+
+template <typename Key, typename Info, typename Alloc>
+class Sequence;
 
 template <typename Key, typename Info>
 class Node
 {
 public:
     Node(const Key &key, const Info &info, Node<Key, Info> *next = nullptr); //default constructor
+    template <typename K, typename I>
+    Node(K &&key, I &&info, Node<Key, Info> *next = nullptr);                //constructs the key and info in place from the given arguments
     Node(const Node<Key, Info> &src);                                        //copy constructor
     bool operator==(const Node<Key, Info> &src) const;                       //comparion operator
     const Key &get_key() const;                                              //returns the key of the node
     const Info &get_info() const;                                            //returns the info of the node
     Node<Key, Info> *get_next() const;                                       //return the pointer to next node
-    void set_key(const Key &key);                                            //sets the key of the node to the given key
     void set_info(const Info &info);                                         //sets the info of the node to the given info
-    void set_next(Node<Key, Info> *next);                                    //sets the pointer to next node to the given pointer to a node
+    void set_info(Info &&info);                                              //moves the given info into the node
     void print();                                                            //displays the key and info of the node
 
 private:
+    template <typename K, typename I, typename A>
+    friend class Sequence;                                                   //only the owning sequence may relink nodes or change keys it indexes
+    void set_key(const Key &key);                                            //sets the key of the node to the given key
+    void set_next(Node<Key, Info> *next);                                    //sets the pointer to next node to the given pointer to a node
+
     Key key;               //key of the node
     Info info;             //info of the node
     Node<Key, Info> *next; //pointer to next node
 };
 
 template <typename Key, typename Info>
-Node<Key, Info>::Node(const Key &key, const Info &info, Node<Key, Info> *next)
+Node<Key, Info>::Node(const Key &key, const Info &info, Node<Key, Info> *next) : key(key), info(info), next(next)
 {
-    this->key = key;
-    this->info = info;
-    this->next = next;
 }
 
 template <typename Key, typename Info>
-Node<Key, Info>::Node(const Node<Key, Info> &src)
+template <typename K, typename I>
+Node<Key, Info>::Node(K &&key, I &&info, Node<Key, Info> *next) : key(std::forward<K>(key)), info(std::forward<I>(info)), next(next)
+{
+}
+
+template <typename Key, typename Info>
+Node<Key, Info>::Node(const Node<Key, Info> &src) : key(src.key), info(src.info), next(nullptr)
 {
-    this->key = src.key;
-    this->info = src.info;
-    this->next = nullptr;
 }
 
 template <typename Key, typename Info>
@@ -77,6 +88,12 @@ void Node<Key, Info>::set_info(const Info &info)
     this->info = info;
 }
 
+template <typename Key, typename Info>
+void Node<Key, Info>::set_info(Info &&info)
+{
+    this->info = std::move(info);
+}
+
 template <typename Key, typename Info>
 void Node<Key, Info>::set_next(Node<Key, Info> *next)
 {
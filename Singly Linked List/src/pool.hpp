@@ -0,0 +1,171 @@
+#pragma once
+#include <vector>
+#include <new>
+#include <type_traits>
+#include <cstddef>
+
+//fixed-size pool for objects of type T: hands out slots from contiguous chunks and recycles
+//freed slots through a free list threaded through them
+template <typename T>
+class NodePool
+{
+public:
+    explicit NodePool(std::size_t per_chunk = 1024); //slots per chunk
+    NodePool(const NodePool<T> &src) = delete;
+    NodePool<T> &operator=(const NodePool<T> &src) = delete;
+    ~NodePool();
+
+    T *allocate();             //returns storage for one object
+    void deallocate(T *slot);  //gives back storage returned by allocate
+    void reset();              //makes every slot free again in O(1); the objects in them must not be used afterwards
+    void release();            //frees all chunks
+    std::size_t live() const;  //returns the number of slots handed out and not given back
+    std::size_t chunks() const; //returns the number of chunks allocated
+
+private:
+    union Slot
+    {
+        Slot *next; //next free slot
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::vector<Slot *> blocks; //chunks, in order of allocation
+    std::size_t per_chunk;
+    std::size_t chunk;          //chunk slots are being carved from
+    std::size_t carved;         //slots of that chunk handed out at least once
+    Slot *free_list;            //recycled slots
+    std::size_t used;           //slots handed out
+};
+
+template <typename T>
+NodePool<T>::NodePool(std::size_t per_chunk)
+{
+    this->per_chunk = per_chunk ? per_chunk : 1;
+    this->chunk = 0;
+    this->carved = 0;
+    this->free_list = nullptr;
+    this->used = 0;
+}
+
+template <typename T>
+NodePool<T>::~NodePool()
+{
+    this->release();
+}
+
+template <typename T>
+T *NodePool<T>::allocate()
+{
+    Slot *slot = this->free_list;
+    if (slot)
+    {
+        this->free_list = slot->next;
+    }
+    else
+    {
+        if (this->carved == this->per_chunk)
+        {
+            this->chunk++;
+            this->carved = 0;
+        }
+        if (this->chunk == this->blocks.size())
+        {
+            this->blocks.push_back(static_cast<Slot *>(::operator new(this->per_chunk * sizeof(Slot))));
+        }
+        slot = this->blocks[this->chunk] + this->carved++;
+    }
+    this->used++;
+    return reinterpret_cast<T *>(slot->storage);
+}
+
+template <typename T>
+void NodePool<T>::deallocate(T *slot)
+{
+    Slot *freed = reinterpret_cast<Slot *>(slot);
+    freed->next = this->free_list;
+    this->free_list = freed;
+    this->used--;
+}
+
+template <typename T>
+void NodePool<T>::reset()
+{
+    //the chunks are kept and carved again from the first one
+    this->chunk = 0;
+    this->carved = 0;
+    this->free_list = nullptr;
+    this->used = 0;
+}
+
+template <typename T>
+void NodePool<T>::release()
+{
+    for (Slot *block : this->blocks)
+    {
+        ::operator delete(block);
+    }
+    this->blocks.clear();
+    this->reset();
+}
+
+template <typename T>
+std::size_t NodePool<T>::live() const
+{
+    return this->used;
+}
+
+template <typename T>
+std::size_t NodePool<T>::chunks() const
+{
+    return this->blocks.size();
+}
+
+//allocator that takes single objects from a NodePool and anything else from the heap; copies
+//share the pool, which must outlive them; a default constructed one has no pool and uses the heap
+template <typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+    using propagate_on_container_swap = std::true_type; //swapped containers keep the pools of their nodes
+
+    PoolAllocator() : pool(nullptr) {}
+    PoolAllocator(NodePool<T> &pool) : pool(&pool) {}
+
+    T *allocate(std::size_t n)
+    {
+        if ((n == 1) and this->pool)
+        {
+            return this->pool->allocate();
+        }
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n)
+    {
+        if ((n == 1) and this->pool)
+        {
+            this->pool->deallocate(p);
+            return;
+        }
+        ::operator delete(p);
+    }
+
+    //frees every object of the pool at once when the caller holds all of them, returns
+    //whether it did; the caller must not destroy or deallocate them afterwards
+    bool release_all(std::size_t held)
+    {
+        if (!this->pool or (this->pool->live() != held))
+        {
+            return false;
+        }
+        this->pool->reset();
+        return true;
+    }
+
+    bool operator==(const PoolAllocator<T> &rhs) const { return this->pool == rhs.pool; }
+    bool operator!=(const PoolAllocator<T> &rhs) const { return this->pool != rhs.pool; }
+
+private:
+    NodePool<T> *pool;
+};
@@ -1,23 +1,132 @@
+#pragma once
 #include "node.hpp"
+#include "skip_index.hpp"
+#include <iterator>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
 
-template <typename Key, typename Info>
+//trait of allocators that can free all of their objects at once, like PoolAllocator
+template <typename Alloc, typename = void>
+struct can_release_all : std::false_type
+{
+};
+
+template <typename Alloc>
+struct can_release_all<Alloc, std::void_t<decltype(std::declval<Alloc &>().release_all(std::size_t()))>> : std::true_type
+{
+};
+
+//trait of keys that std::hash can hash, which the key index needs
+template <typename Key, typename = void>
+struct is_hashable : std::false_type
+{
+};
+
+template <typename Key>
+struct is_hashable<Key, std::void_t<decltype(std::hash<Key>{}(std::declval<const Key &>()))>> : std::true_type
+{
+};
+
+//nodes come from Alloc, e.g. PoolAllocator from pool.hpp or std::pmr::polymorphic_allocator
+template <typename Key, typename Info, typename Alloc = std::allocator<Node<Key, Info>>>
 class Sequence
 {
 public:
+    //forward iterator over the nodes; read elements with get_key and get_info, change them with set_info
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node<Key, Info>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Node<Key, Info> *;
+        using reference = Node<Key, Info> &;
+
+        iterator(Node<Key, Info> *node = nullptr) : node(node) {}
+        reference operator*() const { return *node; }
+        pointer operator->() const { return node; }
+        iterator &operator++()
+        {
+            node = node->get_next();
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            iterator it = *this;
+            ++*this;
+            return it;
+        }
+        bool operator==(const iterator &rhs) const { return node == rhs.node; }
+        bool operator!=(const iterator &rhs) const { return node != rhs.node; }
+
+    private:
+        friend class Sequence;
+        Node<Key, Info> *node; //current node, nullptr past the end
+    };
+
+    //forward iterator over the nodes that cannot change them
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node<Key, Info>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Node<Key, Info> *;
+        using reference = const Node<Key, Info> &;
+
+        const_iterator(const Node<Key, Info> *node = nullptr) : node(node) {}
+        const_iterator(const iterator &it) : node(it.node) {}
+        reference operator*() const { return *node; }
+        pointer operator->() const { return node; }
+        const_iterator &operator++()
+        {
+            node = node->get_next();
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator it = *this;
+            ++*this;
+            return it;
+        }
+        bool operator==(const const_iterator &rhs) const { return node == rhs.node; }
+        bool operator!=(const const_iterator &rhs) const { return node != rhs.node; }
+
+    private:
+        const Node<Key, Info> *node; //current node, nullptr past the end
+    };
+
     //default constructor
     Sequence();
 
+    //constructor with the allocator of the nodes
+    explicit Sequence(const Alloc &alloc);
+
     //copy constructor
-    Sequence(const Sequence<Key, Info> &src);
+    Sequence(const Sequence<Key, Info, Alloc> &src);
+
+    //move constructor; takes the nodes of the source, which is left empty
+    Sequence(Sequence<Key, Info, Alloc> &&src) noexcept;
 
     //destructor
     ~Sequence();
 
     //assignment operator
-    Sequence<Key, Info> &operator=(const Sequence<Key, Info> &src);
+    Sequence<Key, Info, Alloc> &operator=(const Sequence<Key, Info, Alloc> &src);
+
+    //move assignment operator
+    Sequence<Key, Info, Alloc> &operator=(Sequence<Key, Info, Alloc> &&src);
 
     //comparion operator
-    bool operator==(const Sequence<Key, Info> &src) const;
+    bool operator==(const Sequence<Key, Info, Alloc> &src) const;
 
     //capacity
     bool empty() const;        //returns true if the Sequence is empty, else return false
@@ -25,76 +134,286 @@ public:
 
     //modifiers
     void push_front(const Key &key, const Info &info);                                                                           //adds element to the front of the Sequence
+    void push_front(Key &&key, Info &&info);                                                                                     //moves element to the front of the Sequence
     bool pop_front();                                                                                                            //removes element from the front of the Sequence and returns true; if Sequence is empty returns false
     void push_back(const Key &key, const Info &info);                                                                            //adds element to the back of the Sequence
+    void push_back(Key &&key, Info &&info);                                                                                      //moves element to the back of the Sequence
     bool pop_back();                                                                                                             //removes element from the back of the Sequence and returns true; if Sequence is empty returns false
     bool insert_at_pos(const Key &key, const Info &info, const Key &pos, const unsigned int occur = 1, const bool after = true); //inserts element at the given position of the Sequence and returns true; returns false if position not found
     bool insert_at_index(const Key &key, const Info &info, const unsigned int index);                                            //inserts element at the given index of the Sequence and returns true; returns false if index not found
+    template <typename K, typename I>
+    void emplace_front(K &&key, I &&info);                                                                                       //adds element constructed in place from the given key and info arguments to the front of the Sequence
+    template <typename K, typename I>
+    void emplace_back(K &&key, I &&info);                                                                                        //adds element constructed in place from the given key and info arguments to the back of the Sequence
+    template <typename K, typename I>
+    bool emplace_at_index(const unsigned int index, K &&key, I &&info);                                                          //inserts element constructed in place at the given index of the Sequence and returns true; returns false if index not found
     bool modify_at_pos(const Info &info, const Key &pos, const unsigned int occur = 1);                                          //modifies the info of the element in the given position of the Sequence and returns true; returns false if position not found
     bool modify_at_index(const Info &info, const unsigned int index);                                                            //modifies the info of the element in the given index of the Sequence and returns true; returns false if index not found
     bool erase_at_pos(const Key &pos, const unsigned int occur = 1);                                                             //removes the element in the given position of the Sequence and returns true; returns false if position not found
     bool erase_at_index(const unsigned int index);                                                                               //removes the element in the given index of the Sequence and returns true; returns false if index not found
-    void swap(Sequence<Key, Info> &src);                                                                                         //swaps the elements of the given source and the object
+    void swap(Sequence<Key, Info, Alloc> &src);                                                                                  //swaps the elements of the given source and the object
+    void splice(Sequence<Key, Info, Alloc> &src);                                                                                //moves all the elements of the given source to the back of the Sequence without copying them
     void clear();                                                                                                                //erases all the elements of the list
+    Alloc get_allocator() const;                                                                                                 //returns the allocator of the nodes
+    iterator insert_after(iterator position, const Key &key, const Info &info);                                                  //inserts element after the element at the given iterator and returns an iterator to it
+    iterator erase_after(iterator position);                                                                                     //removes the element after the element at the given iterator and returns an iterator to the element that followed it
+
+    //key index: a hash map from each key to its nodes in order, kept up to date by every modifier; count is O(1) and
+    //finding the n-th occurrence of a key is O(1), so get, try_get and modify_at_pos no longer walk the Sequence;
+    //every node also gets a label growing along the Sequence, so a node inserted in the middle is placed among the
+    //other nodes with its key by bisection, and the index of a node is found from the finger or, with the position
+    //index on, by bisection; swap and moves take the index along with the nodes; keys must not be changed through
+    //iterators while it is on
+    void enable_index();  //builds the key index
+    void disable_index(); //drops the key index
+    bool indexed() const; //returns true if the key index is on
+
+    //position index: a skip list over the nodes with the number of nodes each express link spans, kept up to date
+    //by every modifier; reaching an index is O(log n) instead of a walk from the head, which speeds up key_at, info_at,
+    //modify_at_index, insert_at_index, erase_at_index and pop_back; inserting or erasing by key learns the index of
+    //the change on the way to the node, while inserting or erasing by iterator counts it from the head unless the key
+    //index is on too
+    void enable_position_index();  //builds the position index
+    void disable_position_index(); //drops the position index
+    bool position_indexed() const; //returns true if the position index is on
+
+    //iterators
+    iterator begin() { return iterator(head); }
+    iterator end() { return iterator(); }
+    const_iterator begin() const { return const_iterator(head); }
+    const_iterator end() const { return const_iterator(); }
+    const_iterator cbegin() const { return const_iterator(head); }
+    const_iterator cend() const { return const_iterator(); }
 
     //operations
     int get_index(const Key &pos, const unsigned int occur = 1) const;  //returns the index of the element at the given position; returns -1 if position not found
     const Info get(const Key &pos, const unsigned int occur = 1) const; //returns the info of the element at the given position; throws and error if position not found
     const Key key_at(const unsigned int index) const;                   //returns the key of the element at the given index; throws and error if index out of range
     const Info info_at(const unsigned int index) const;                 //returns the info of the element at the given index; throws and error if index out of range
+    const Info *try_get(const Key &pos, const unsigned int occur = 1) const;                  //returns a pointer to the info of the element at the given position; returns nullptr if position not found
+    Info get_or(const Key &pos, const Info &fallback, const unsigned int occur = 1) const;   //returns the info of the element at the given position; returns fallback if position not found
+    const Key *try_key_at(const unsigned int index) const;                                   //returns a pointer to the key of the element at the given index; returns nullptr if index out of range
+    const Info *try_info_at(const unsigned int index) const;                                 //returns a pointer to the info of the element at the given index; returns nullptr if index out of range
     unsigned int count(const Key &key) const;                           //returns the number of elements with the given key
     void print() const;                                                 //prints all the elements of the Sequence
 
 private:
     Node<Key, Info> *head;                                     //head node
-    Node<Key, Info> *get_node(const unsigned int index) const; //returns the node at the given index; returns nullptr if index is out of range
+    Node<Key, Info> *tail;                                     //tail node
+    unsigned int length;                                       //number of elements
+    Node<Key, Info> *get_node(const unsigned int index) const; //returns the node at the given index, starting from the finger when it is not past it; returns nullptr if index is out of range
+    Node<Key, Info> *find_node(const Key &pos, const unsigned int occur, Node<Key, Info> **prev = nullptr, unsigned int *at = nullptr) const; //returns the node at the given position and sets prev and at, if given, to the node before it and its index; returns nullptr if position not found
+    void link_after(Node<Key, Info> *prev, Node<Key, Info> *node, const unsigned int at); //links the new node after prev, at the given index
+    void unlink_after(Node<Key, Info> *prev, const unsigned int at);                       //removes the node after prev, which is at the given index
+
+    //nodes of each key in order, and a label for every node that grows along the Sequence, so that the order
+    //of two nodes is known without walking from one to the other
+    struct KeyIndex
+    {
+        std::unordered_map<Key, std::vector<Node<Key, Info> *>> nodes;
+        std::unordered_map<const Node<Key, Info> *, std::uint64_t> order;
+    };
+    KeyIndex *key_index; //nullptr when the index is off
+    void index_add(Node<Key, Info> *prev, Node<Key, Info> *node); //adds a node already linked into the Sequence after prev to the index
+    void index_remove(Node<Key, Info> *node);                     //removes a node from the index
+    void index_build();                                           //fills the index from the nodes
+    void index_relabel();                                         //spreads the labels of all the nodes evenly
+    void index_spread(Node<Key, Info> *prev, Node<Key, Info> *node); //relabels node and the fewest nodes after it that leave room between their labels
+    std::uint64_t label_of(const Node<Key, Info> *node) const;    //returns the label of a node in the index
+    unsigned int locate(Node<Key, Info> *target, Node<Key, Info> **prev) const; //returns the index of a node in the index and sets prev, if given, to the node before it
+
+    SkipIndex<Key, Info> *skip_index;                             //express links over the nodes; nullptr when the position index is off
+    unsigned int position_of(Node<Key, Info> *node) const;       //returns the index of the node if the position index is on, else 0
+
+    //finger: the last node reached by index, so that reading indices in increasing order walks the Sequence once;
+    //modifiers drop it unless they only change what follows it, and because const reads move it they must not run
+    //concurrently on one Sequence
+    mutable Node<Key, Info> *finger;       //last node reached, nullptr when unknown
+    mutable unsigned int finger_index;     //index of that node
+
+    using traits = std::allocator_traits<Alloc>;
+    Alloc alloc; //allocator of the nodes
+
+    template <typename... Args>
+    Node<Key, Info> *create_node(Args &&...args); //allocates and constructs a node
+    void destroy_node(Node<Key, Info> *node);     //destroys and deallocates a node
 };
 
-template <typename Key, typename Info>
-Sequence<Key, Info>::Sequence()
+template <typename Key, typename Info, typename Alloc>
+Sequence<Key, Info, Alloc>::Sequence()
 {
     this->head = nullptr;
+    this->tail = nullptr;
+    this->length = 0;
+    this->key_index = nullptr;
+    this->skip_index = nullptr;
+    this->finger = nullptr;
+    this->finger_index = 0;
 }
 
-template <typename Key, typename Info>
-Sequence<Key, Info>::Sequence(const Sequence<Key, Info> &src)
+template <typename Key, typename Info, typename Alloc>
+Sequence<Key, Info, Alloc>::Sequence(const Alloc &alloc) : alloc(alloc)
 {
     this->head = nullptr;
+    this->tail = nullptr;
+    this->length = 0;
+    this->key_index = nullptr;
+    this->skip_index = nullptr;
+    this->finger = nullptr;
+    this->finger_index = 0;
+}
+
+template <typename Key, typename Info, typename Alloc>
+Sequence<Key, Info, Alloc>::Sequence(const Sequence<Key, Info, Alloc> &src) : alloc(traits::select_on_container_copy_construction(src.alloc))
+{
+    this->head = nullptr;
+    this->tail = nullptr;
+    this->length = 0;
+    this->key_index = nullptr;
+    this->skip_index = nullptr;
+    this->finger = nullptr;
+    this->finger_index = 0;
     *this = src;
+    if constexpr (is_hashable<Key>::value)
+    {
+        if (src.key_index)
+        {
+            this->enable_index();
+        }
+    }
+    if (src.skip_index)
+    {
+        this->enable_position_index();
+    }
 }
 
-template <typename Key, typename Info>
-Sequence<Key, Info>::~Sequence()
+template <typename Key, typename Info, typename Alloc>
+Sequence<Key, Info, Alloc>::Sequence(Sequence<Key, Info, Alloc> &&src) noexcept : alloc(std::move(src.alloc))
+{
+    this->head = src.head;
+    this->tail = src.tail;
+    this->length = src.length;
+    this->key_index = src.key_index;
+    this->skip_index = src.skip_index;
+    this->finger = src.finger;
+    this->finger_index = src.finger_index;
+    src.head = nullptr;
+    src.tail = nullptr;
+    src.length = 0;
+    src.key_index = nullptr;
+    src.skip_index = nullptr;
+    src.finger = nullptr;
+}
+
+template <typename Key, typename Info, typename Alloc>
+Sequence<Key, Info, Alloc>::~Sequence()
 {
     this->clear();
+    this->disable_index();
+    this->disable_position_index();
 }
 
-template <typename Key, typename Info>
-Sequence<Key, Info> &Sequence<Key, Info>::operator=(const Sequence<Key, Info> &src)
+template <typename Key, typename Info, typename Alloc>
+Sequence<Key, Info, Alloc> &Sequence<Key, Info, Alloc>::operator=(const Sequence<Key, Info, Alloc> &src)
 {
-    if (*this == src)
+    if (this == &src)
     {
         return *this;
     }
-    this->clear();
-    if (src.head)
+    //the index is built again once the keys are in place
+    bool indexed = this->indexed();
+    bool position_indexed = this->position_indexed();
+    this->disable_index();
+    this->disable_position_index();
+    this->finger = nullptr;
+    //the existing nodes are overwritten, so only a longer source allocates
+    Node<Key, Info> *node = this->head;
+    Node<Key, Info> *prev = nullptr;
+    const Node<Key, Info> *src_node = src.head;
+    while (node and src_node)
     {
-        this->head = new Node<Key, Info>(*src.head);
-        Node<Key, Info> *node = this->head;
-        Node<Key, Info> *src_node = src.head->get_next();
-        while (src_node)
+        node->set_key(src_node->get_key());
+        node->set_info(src_node->get_info());
+        prev = node;
+        node = node->get_next();
+        src_node = src_node->get_next();
+    }
+    if (node)
+    {
+        if (prev)
         {
-            Node<Key, Info> *n = new Node<Key, Info>(*src_node);
-            node->set_next(n);
-            node = node->get_next();
-            src_node = src_node->get_next();
+            prev->set_next(nullptr);
+        }
+        else
+        {
+            this->head = nullptr;
         }
+        this->tail = prev;
+        this->length = src.length;
+        while (node)
+        {
+            Node<Key, Info> *next = node->get_next();
+            this->destroy_node(node);
+            node = next;
+        }
+    }
+    for (; src_node; src_node = src_node->get_next())
+    {
+        this->push_back(src_node->get_key(), src_node->get_info());
+    }
+    if constexpr (is_hashable<Key>::value)
+    {
+        if (indexed)
+        {
+            this->enable_index();
+        }
+    }
+    if (position_indexed)
+    {
+        this->enable_position_index();
     }
     return *this;
 }
 
-template <typename Key, typename Info>
-bool Sequence<Key, Info>::operator==(const Sequence<Key, Info> &src) const
+template <typename Key, typename Info, typename Alloc>
+Sequence<Key, Info, Alloc> &Sequence<Key, Info, Alloc>::operator=(Sequence<Key, Info, Alloc> &&src)
+{
+    if (this == &src)
+    {
+        return *this;
+    }
+    this->clear();
+    if constexpr (traits::propagate_on_container_move_assignment::value)
+    {
+        this->alloc = std::move(src.alloc);
+    }
+    else if (!(this->alloc == src.alloc))
+    {
+        //nodes cannot change hands between allocators, so they are copied
+        *this = src;
+        src.clear();
+        return *this;
+    }
+    this->disable_index();
+    this->disable_position_index();
+    this->head = src.head;
+    this->tail = src.tail;
+    this->length = src.length;
+    this->key_index = src.key_index;
+    this->skip_index = src.skip_index;
+    this->finger = src.finger;
+    this->finger_index = src.finger_index;
+    src.head = nullptr;
+    src.tail = nullptr;
+    src.length = 0;
+    src.key_index = nullptr;
+    src.skip_index = nullptr;
+    src.finger = nullptr;
+    return *this;
+}
+
+template <typename Key, typename Info, typename Alloc>
+bool Sequence<Key, Info, Alloc>::operator==(const Sequence<Key, Info, Alloc> &src) const
 {
     unsigned int size = src.size();
     if (size != this->size())
@@ -116,8 +435,8 @@ bool Sequence<Key, Info>::operator==(const Sequence<Key, Info> &src) const
     return true;
 }
 
-template <typename Key, typename Info>
-bool Sequence<Key, Info>::empty() const
+template <typename Key, typename Info, typename Alloc>
+bool Sequence<Key, Info, Alloc>::empty() const
 {
     if (this->head)
     {
@@ -126,128 +445,180 @@ bool Sequence<Key, Info>::empty() const
     return true;
 }
 
-template <typename Key, typename Info>
-unsigned int Sequence<Key, Info>::size() const
+template <typename Key, typename Info, typename Alloc>
+unsigned int Sequence<Key, Info, Alloc>::size() const
 {
-    Node<Key, Info> *node = head;
-    unsigned int size = 0;
-    while (node)
-    {
-        size++;
-        node = node->get_next();
-    }
-    return size;
+    return this->length;
 }
 
-template <typename Key, typename Info>
-void Sequence<Key, Info>::push_front(const Key &key, const Info &info)
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::push_front(const Key &key, const Info &info)
 {
-    this->head = new Node<Key, Info>(key, info, this->head);
+    this->emplace_front(key, info);
 }
 
-template <typename Key, typename Info>
-bool Sequence<Key, Info>::pop_front()
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::push_front(Key &&key, Info &&info)
+{
+    this->emplace_front(std::move(key), std::move(info));
+}
+
+template <typename Key, typename Info, typename Alloc>
+bool Sequence<Key, Info, Alloc>::pop_front()
 {
     if (head)
     {
         Node<Key, Info> *node = this->head->get_next();
-        delete head;
+        this->index_remove(head);
+        if (this->skip_index)
+        {
+            this->skip_index->erase(0);
+        }
+        this->finger = nullptr;
+        this->destroy_node(head);
         head = node;
+        if (!head)
+        {
+            this->tail = nullptr;
+        }
+        this->length--;
         return true;
     }
     return false;
 }
 
-template <typename Key, typename Info>
-void Sequence<Key, Info>::push_back(const Key &key, const Info &info)
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::push_back(const Key &key, const Info &info)
 {
-    if (this->head)
-    {
-        Node<Key, Info> *node = get_node(size() - 1);
-        if (node)
-        {
-            node->set_next(new Node<Key, Info>(key, info));
-        }
-        return;
-    }
-    this->head = new Node<Key, Info>(key, info);
+    this->emplace_back(key, info);
 }
 
-template <typename Key, typename Info>
-bool Sequence<Key, Info>::pop_back()
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::push_back(Key &&key, Info &&info)
 {
-    unsigned int size = this->size();
-    if (size == 1)
+    this->emplace_back(std::move(key), std::move(info));
+}
+
+template <typename Key, typename Info, typename Alloc>
+bool Sequence<Key, Info, Alloc>::pop_back()
+{
+    if (this->length == 1)
     {
-        delete this->head;
-        this->head = nullptr;
-        return true;
+        return this->pop_front();
     }
-    Node<Key, Info> *node = get_node(size - 2);
+    Node<Key, Info> *node = get_node(this->length - 2);
     if (node)
     {
-        delete node->get_next();
-        node->set_next(nullptr);
+        this->unlink_after(node, this->length - 1);
         return true;
     }
     return false;
 }
 
-template <typename Key, typename Info>
-bool Sequence<Key, Info>::insert_at_pos(const Key &key, const Info &info, const Key &pos, const unsigned int occur, const bool after)
+template <typename Key, typename Info, typename Alloc>
+bool Sequence<Key, Info, Alloc>::insert_at_pos(const Key &key, const Info &info, const Key &pos, const unsigned int occur, const bool after)
 {
-    int index = this->get_index(pos, occur);
-    if (index < 0)
+    Node<Key, Info> *prev = nullptr;
+    unsigned int at = 0;
+    Node<Key, Info> *node = this->find_node(pos, occur, after ? nullptr : &prev, this->skip_index ? &at : nullptr);
+    if (!node)
     {
         return false;
     }
-    if ((index == 0) and !after)
-    {
-        this->push_front(key, info);
-        return true;
-    }
     if (!after)
     {
-        index--;
+        if (!prev)
+        {
+            this->push_front(key, info);
+            return true;
+        }
+        node = prev;
+        at--;
     }
-    Node<Key, Info> *node = get_node(index);
-    node->set_next(new Node<Key, Info>(key, info, node->get_next()));
+    this->link_after(node, this->create_node(key, info, node->get_next()), at + 1);
     return true;
 }
 
-template <typename Key, typename Info>
-bool Sequence<Key, Info>::insert_at_index(const Key &key, const Info &info, const unsigned int index)
+template <typename Key, typename Info, typename Alloc>
+bool Sequence<Key, Info, Alloc>::insert_at_index(const Key &key, const Info &info, const unsigned int index)
+{
+    return this->emplace_at_index(index, key, info);
+}
+
+template <typename Key, typename Info, typename Alloc>
+template <typename K, typename I>
+void Sequence<Key, Info, Alloc>::emplace_front(K &&key, I &&info)
+{
+    this->head = this->create_node(std::forward<K>(key), std::forward<I>(info), this->head);
+    if (!this->tail)
+    {
+        this->tail = this->head;
+    }
+    this->length++;
+    this->index_add(nullptr, this->head);
+    if (this->skip_index)
+    {
+        this->skip_index->insert(0, this->head);
+    }
+    this->finger = nullptr;
+}
+
+template <typename Key, typename Info, typename Alloc>
+template <typename K, typename I>
+void Sequence<Key, Info, Alloc>::emplace_back(K &&key, I &&info)
+{
+    Node<Key, Info> *node = this->create_node(std::forward<K>(key), std::forward<I>(info));
+    Node<Key, Info> *last = this->tail;
+    if (this->tail)
+    {
+        this->tail->set_next(node);
+    }
+    else
+    {
+        this->head = node;
+    }
+    this->tail = node;
+    this->length++;
+    this->index_add(last, node);
+    if (this->skip_index)
+    {
+        this->skip_index->insert(this->length - 1, node);
+    }
+}
+
+template <typename Key, typename Info, typename Alloc>
+template <typename K, typename I>
+bool Sequence<Key, Info, Alloc>::emplace_at_index(const unsigned int index, K &&key, I &&info)
 {
     if (index == 0)
     {
-        this->push_front(key, info);
+        this->emplace_front(std::forward<K>(key), std::forward<I>(info));
         return true;
     }
     Node<Key, Info> *node = get_node(index - 1);
 
     if (node)
     {
-        node->set_next(new Node<Key, Info>(key, info, node->get_next()));
+        this->link_after(node, this->create_node(std::forward<K>(key), std::forward<I>(info), node->get_next()), index);
         return true;
     }
     return false;
 }
 
-template <typename Key, typename Info>
-bool Sequence<Key, Info>::modify_at_pos(const Info &info, const Key &pos, const unsigned int occur)
+template <typename Key, typename Info, typename Alloc>
+bool Sequence<Key, Info, Alloc>::modify_at_pos(const Info &info, const Key &pos, const unsigned int occur)
 {
-    int index = this->get_index(pos, occur);
-    if (index < 0)
+    Node<Key, Info> *node = this->find_node(pos, occur);
+    if (!node)
     {
         return false;
     }
-    Node<Key, Info> *node = get_node(index);
     node->set_info(info);
     return true;
 }
 
-template <typename Key, typename Info>
-bool Sequence<Key, Info>::modify_at_index(const Info &info, const unsigned int index)
+template <typename Key, typename Info, typename Alloc>
+bool Sequence<Key, Info, Alloc>::modify_at_index(const Info &info, const unsigned int index)
 {
     Node<Key, Info> *node = get_node(index);
     if (node)
@@ -258,29 +629,26 @@ bool Sequence<Key, Info>::modify_at_index(const Info &info, const unsigned int i
     return false;
 }
 
-template <typename Key, typename Info>
-bool Sequence<Key, Info>::erase_at_pos(const Key &pos, const unsigned int occur)
+template <typename Key, typename Info, typename Alloc>
+bool Sequence<Key, Info, Alloc>::erase_at_pos(const Key &pos, const unsigned int occur)
 {
-    int index = this->get_index(pos, occur);
-    if (index < 0)
+    Node<Key, Info> *prev = nullptr;
+    unsigned int at = 0;
+    if (!this->find_node(pos, occur, &prev, &at))
     {
         return false;
     }
-    if (index == 0)
+    if (!prev)
     {
         this->pop_front();
         return true;
     }
-
-    Node<Key, Info> *prev = get_node(index - 1);
-    Node<Key, Info> *node = prev->get_next();
-    prev->set_next(node->get_next());
-    delete node;
+    this->unlink_after(prev, at);
     return true;
 }
 
-template <typename Key, typename Info>
-bool Sequence<Key, Info>::erase_at_index(const unsigned int index)
+template <typename Key, typename Info, typename Alloc>
+bool Sequence<Key, Info, Alloc>::erase_at_index(const unsigned int index)
 {
     if (index >= this->size())
     {
@@ -293,91 +661,324 @@ bool Sequence<Key, Info>::erase_at_index(const unsigned int index)
         return true;
     }
 
-    Node<Key, Info> *prev = get_node(index - 1);
-    Node<Key, Info> *node = prev->get_next();
-    prev->set_next(node->get_next());
-    delete node;
+    this->unlink_after(get_node(index - 1), index);
     return true;
 }
 
-template <typename Key, typename Info>
-void Sequence<Key, Info>::swap(Sequence<Key, Info> &src)
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::swap(Sequence<Key, Info, Alloc> &src)
 {
+    if constexpr (traits::propagate_on_container_swap::value)
+    {
+        std::swap(this->alloc, src.alloc);
+    }
     Node<Key, Info> *tmp = src.head;
     src.head = this->head;
     this->head = tmp;
+    tmp = src.tail;
+    src.tail = this->tail;
+    this->tail = tmp;
+    unsigned int len = src.length;
+    src.length = this->length;
+    this->length = len;
+    KeyIndex *index = src.key_index;
+    src.key_index = this->key_index;
+    this->key_index = index;
+    SkipIndex<Key, Info> *skip = src.skip_index;
+    src.skip_index = this->skip_index;
+    this->skip_index = skip;
+    std::swap(this->finger, src.finger);
+    std::swap(this->finger_index, src.finger_index);
 }
 
-template <typename Key, typename Info>
-void Sequence<Key, Info>::clear()
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::splice(Sequence<Key, Info, Alloc> &src)
 {
+    if ((this == &src) or !src.head)
+    {
+        return;
+    }
+    if (!(this->alloc == src.alloc))
+    {
+        //nodes cannot change hands between allocators, so they are copied
+        for (Node<Key, Info> *node = src.head; node; node = node->get_next())
+        {
+            this->push_back(node->get_key(), node->get_info());
+        }
+        src.clear();
+        return;
+    }
+    if constexpr (is_hashable<Key>::value)
+    {
+        if (src.key_index)
+        {
+            src.key_index->nodes.clear();
+            src.key_index->order.clear();
+        }
+    }
+    Node<Key, Info> *last = this->tail;
+    if (this->skip_index)
+    {
+        unsigned int at = this->length;
+        for (Node<Key, Info> *node = src.head; node; node = node->get_next())
+        {
+            this->skip_index->insert(at++, node);
+        }
+    }
+    if (src.skip_index)
+    {
+        src.skip_index->clear();
+    }
+    if (this->tail)
+    {
+        this->tail->set_next(src.head);
+    }
+    else
+    {
+        this->head = src.head;
+    }
+    this->tail = src.tail;
+    this->length += src.length;
+    //the nodes are labelled once they are linked, so that a relabelling reaches them
+    for (Node<Key, Info> *node = last ? last->get_next() : this->head; this->key_index and node; node = node->get_next())
+    {
+        this->index_add(last, node);
+        last = node;
+    }
+    src.head = nullptr;
+    src.tail = nullptr;
+    src.length = 0;
+    src.finger = nullptr;
+}
+
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::clear()
+{
+    this->finger = nullptr;
+    if constexpr (is_hashable<Key>::value)
+    {
+        if (this->key_index)
+        {
+            this->key_index->nodes.clear();
+            this->key_index->order.clear();
+        }
+    }
+    if (this->skip_index)
+    {
+        this->skip_index->clear();
+    }
+    //a pool holding nothing but this Sequence's nodes is emptied at once
+    if constexpr (can_release_all<Alloc>::value and std::is_trivially_destructible<Node<Key, Info>>::value)
+    {
+        if (this->alloc.release_all(this->length))
+        {
+            this->head = nullptr;
+            this->tail = nullptr;
+            this->length = 0;
+            return;
+        }
+    }
     Node<Key, Info> *node = this->head;
     Node<Key, Info> *next = nullptr;
     while (node)
     {
         next = node->get_next();
-        delete node;
+        this->destroy_node(node);
         node = next;
     }
     this->head = nullptr;
+    this->tail = nullptr;
+    this->length = 0;
 }
 
-template <typename Key, typename Info>
-int Sequence<Key, Info>::get_index(const Key &pos, const unsigned int occur) const
+template <typename Key, typename Info, typename Alloc>
+typename Sequence<Key, Info, Alloc>::iterator Sequence<Key, Info, Alloc>::insert_after(iterator position, const Key &key, const Info &info)
+{
+    Node<Key, Info> *node = position.node;
+    this->link_after(node, this->create_node(key, info, node->get_next()), this->position_of(node) + 1);
+    return iterator(node->get_next());
+}
+
+template <typename Key, typename Info, typename Alloc>
+typename Sequence<Key, Info, Alloc>::iterator Sequence<Key, Info, Alloc>::erase_after(iterator position)
+{
+    Node<Key, Info> *prev = position.node;
+    if (!prev->get_next())
+    {
+        return end();
+    }
+    this->unlink_after(prev, this->position_of(prev) + 1);
+    return iterator(prev->get_next());
+}
+
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::enable_index()
+{
+    static_assert(is_hashable<Key>::value, "the key index needs std::hash<Key>");
+    if (!this->key_index)
+    {
+        this->key_index = new KeyIndex;
+    }
+    this->index_build();
+}
+
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::disable_index()
+{
+    if constexpr (is_hashable<Key>::value)
+    {
+        delete this->key_index;
+    }
+    this->key_index = nullptr;
+}
+
+template <typename Key, typename Info, typename Alloc>
+bool Sequence<Key, Info, Alloc>::indexed() const
+{
+    return this->key_index != nullptr;
+}
+
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::enable_position_index()
+{
+    if (!this->skip_index)
+    {
+        this->skip_index = new SkipIndex<Key, Info>;
+    }
+    this->skip_index->build(this->head);
+}
+
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::disable_position_index()
+{
+    delete this->skip_index;
+    this->skip_index = nullptr;
+}
+
+template <typename Key, typename Info, typename Alloc>
+bool Sequence<Key, Info, Alloc>::position_indexed() const
+{
+    return this->skip_index != nullptr;
+}
+
+template <typename Key, typename Info, typename Alloc>
+int Sequence<Key, Info, Alloc>::get_index(const Key &pos, const unsigned int occur) const
 {
-    int occ = 1;
     int index = 0;
+    if constexpr (is_hashable<Key>::value)
+    {
+        if (this->key_index)
+        {
+            Node<Key, Info> *target = this->find_node(pos, occur);
+            if (!target)
+            {
+                return -1;
+            }
+            return this->locate(target, nullptr);
+        }
+    }
+    unsigned int occ = 0;
     Node<Key, Info> *node = this->head;
     while (node)
     {
-        if ((node->get_key() == pos) and (occ = occur))
+        if ((node->get_key() == pos) and (++occ == occur))
         {
             return index;
         }
-        occ++;
         index++;
         node = node->get_next();
     }
     return -1;
 }
 
-template <typename Key, typename Info>
-const Info Sequence<Key, Info>::get(const Key &pos, const unsigned int occur) const
+template <typename Key, typename Info, typename Alloc>
+const Info Sequence<Key, Info, Alloc>::get(const Key &pos, const unsigned int occur) const
 {
-    int index = this->get_index(pos, occur);
-    if (index < 0)
+    const Info *info = this->try_get(pos, occur);
+    if (info)
     {
-        throw std::out_of_range("Index out of range");
+        return *info;
     }
-    Node<Key, Info> *node = this->get_node(index);
-    return node->get_info();
+    throw std::out_of_range("Index out of range");
 }
 
-template <typename Key, typename Info>
-const Key Sequence<Key, Info>::key_at(const unsigned int index) const
+template <typename Key, typename Info, typename Alloc>
+const Key Sequence<Key, Info, Alloc>::key_at(const unsigned int index) const
+{
+    const Key *key = this->try_key_at(index);
+    if (key)
+    {
+        return *key;
+    }
+    throw std::out_of_range("Index out of range");
+}
+
+template <typename Key, typename Info, typename Alloc>
+const Info Sequence<Key, Info, Alloc>::info_at(const unsigned int index) const
+{
+    const Info *info = this->try_info_at(index);
+    if (info)
+    {
+        return *info;
+    }
+    throw std::out_of_range("Index out of range");
+}
+
+template <typename Key, typename Info, typename Alloc>
+const Info *Sequence<Key, Info, Alloc>::try_get(const Key &pos, const unsigned int occur) const
+{
+    Node<Key, Info> *node = this->find_node(pos, occur);
+    if (node)
+    {
+        return &node->get_info();
+    }
+    return nullptr;
+}
+
+template <typename Key, typename Info, typename Alloc>
+Info Sequence<Key, Info, Alloc>::get_or(const Key &pos, const Info &fallback, const unsigned int occur) const
+{
+    const Info *info = this->try_get(pos, occur);
+    if (info)
+    {
+        return *info;
+    }
+    return fallback;
+}
+
+template <typename Key, typename Info, typename Alloc>
+const Key *Sequence<Key, Info, Alloc>::try_key_at(const unsigned int index) const
 {
     Node<Key, Info> *node = this->get_node(index);
     if (node)
     {
-        return node->get_key();
+        return &node->get_key();
     }
-    throw std::out_of_range("Index out of range");
+    return nullptr;
 }
 
-template <typename Key, typename Info>
-const Info Sequence<Key, Info>::info_at(const unsigned int index) const
+template <typename Key, typename Info, typename Alloc>
+const Info *Sequence<Key, Info, Alloc>::try_info_at(const unsigned int index) const
 {
     Node<Key, Info> *node = this->get_node(index);
     if (node)
     {
-        return node->get_info();
+        return &node->get_info();
     }
-    throw std::out_of_range("Index out of range");
+    return nullptr;
 }
 
-template <typename Key, typename Info>
-unsigned int Sequence<Key, Info>::count(const Key &key) const
+template <typename Key, typename Info, typename Alloc>
+unsigned int Sequence<Key, Info, Alloc>::count(const Key &key) const
 {
+    if constexpr (is_hashable<Key>::value)
+    {
+        if (this->key_index)
+        {
+            auto it = this->key_index->nodes.find(key);
+            return it == this->key_index->nodes.end() ? 0 : it->second.size();
+        }
+    }
     unsigned int occ = 0;
     Node<Key, Info> *node = this->head;
     while (node)
@@ -391,8 +992,8 @@ unsigned int Sequence<Key, Info>::count(const Key &key) const
     return occ;
 }
 
-template <typename Key, typename Info>
-void Sequence<Key, Info>::print() const
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::print() const
 {
     Node<Key, Info> *node = this->head;
     while (node)
@@ -402,19 +1003,415 @@ void Sequence<Key, Info>::print() const
     }
 }
 
-template <typename Key, typename Info>
-Node<Key, Info> *Sequence<Key, Info>::get_node(const unsigned int index) const
+template <typename Key, typename Info, typename Alloc>
+Node<Key, Info> *Sequence<Key, Info, Alloc>::get_node(const unsigned int index) const
 {
+    if (index >= this->length)
+    {
+        return nullptr;
+    }
     unsigned int i = 0;
     Node<Key, Info> *node = this->head;
-    while (node)
+    if (this->finger and (this->finger_index <= index))
+    {
+        i = this->finger_index;
+        node = this->finger;
+    }
+    //a few steps from the finger are cheaper than a descent of the skip list
+    if (this->skip_index and (index - i > 8))
     {
-        if (i == index)
+        i = index;
+        node = this->skip_index->find(this->head, index);
+    }
+    for (; i < index; i++)
+    {
+        node = node->get_next();
+    }
+    this->finger = node;
+    this->finger_index = index;
+    return node;
+}
+
+template <typename Key, typename Info, typename Alloc>
+Node<Key, Info> *Sequence<Key, Info, Alloc>::find_node(const Key &pos, const unsigned int occur, Node<Key, Info> **prev, unsigned int *at) const
+{
+    Node<Key, Info> *before = nullptr;
+    if constexpr (is_hashable<Key>::value)
+    {
+        if (this->key_index)
         {
+            auto it = this->key_index->nodes.find(pos);
+            if ((it == this->key_index->nodes.end()) or (occur == 0) or (occur > it->second.size()))
+            {
+                return nullptr;
+            }
+            Node<Key, Info> *target = it->second[occur - 1];
+            if (prev or at)
+            {
+                unsigned int index = this->locate(target, prev);
+                if (at)
+                {
+                    *at = index;
+                }
+            }
+            return target;
+        }
+    }
+    unsigned int occ = 0;
+    unsigned int index = 0;
+    for (Node<Key, Info> *node = this->head; node; node = node->get_next(), index++)
+    {
+        if ((node->get_key() == pos) and (++occ == occur))
+        {
+            if (at)
+            {
+                *at = index;
+            }
+            //the finger goes where the caller will link or unlink a node
+            if (prev)
+            {
+                *prev = before;
+                if (before)
+                {
+                    this->finger = before;
+                    this->finger_index = index - 1;
+                }
+            }
+            else
+            {
+                this->finger = node;
+                this->finger_index = index;
+            }
             return node;
         }
-        i++;
-        node = node->get_next();
+        before = node;
     }
     return nullptr;
 }
+
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::link_after(Node<Key, Info> *prev, Node<Key, Info> *node, const unsigned int at)
+{
+    prev->set_next(node);
+    if (prev == this->tail)
+    {
+        this->tail = node;
+    }
+    if (this->finger != prev)
+    {
+        this->finger = nullptr;
+    }
+    this->length++;
+    this->index_add(prev, node);
+    if (this->skip_index)
+    {
+        this->skip_index->insert(at, node);
+    }
+}
+
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::unlink_after(Node<Key, Info> *prev, const unsigned int at)
+{
+    Node<Key, Info> *node = prev->get_next();
+    prev->set_next(node->get_next());
+    if (node == this->tail)
+    {
+        this->tail = prev;
+    }
+    if (this->finger != prev)
+    {
+        this->finger = nullptr;
+    }
+    this->index_remove(node);
+    if (this->skip_index)
+    {
+        this->skip_index->erase(at);
+    }
+    this->destroy_node(node);
+    this->length--;
+}
+
+template <typename Key, typename Info, typename Alloc>
+unsigned int Sequence<Key, Info, Alloc>::position_of(Node<Key, Info> *node) const
+{
+    unsigned int at = 0;
+    if (this->skip_index)
+    {
+        if constexpr (is_hashable<Key>::value)
+        {
+            if (this->key_index)
+            {
+                return this->locate(node, nullptr);
+            }
+        }
+        //an iterator holds no index, so without the labels of the key index it is counted from the head
+        for (const Node<Key, Info> *n = this->head; n != node; n = n->get_next())
+        {
+            at++;
+        }
+    }
+    return at;
+}
+
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::index_add(Node<Key, Info> *prev, Node<Key, Info> *node)
+{
+    if constexpr (is_hashable<Key>::value)
+    {
+        if (!this->key_index)
+        {
+            return;
+        }
+        //the label goes halfway between its neighbours', or a step away from the only one at either end
+        const std::uint64_t step = std::uint64_t(1) << 32;
+        std::uint64_t lo = prev ? this->label_of(prev) : 0;
+        auto next = node->get_next() ? this->key_index->order.find(node->get_next()) : this->key_index->order.end();
+        std::uint64_t hi = next != this->key_index->order.end() ? next->second : UINT64_MAX;
+        std::uint64_t label;
+        if (!prev and (next == this->key_index->order.end()))
+        {
+            label = std::uint64_t(1) << 63;
+        }
+        else if (!prev)
+        {
+            label = hi - std::min(hi / 2, step);
+        }
+        else if (next == this->key_index->order.end())
+        {
+            label = lo + std::min((hi - lo) / 2, step);
+        }
+        else
+        {
+            label = lo + (hi - lo) / 2;
+        }
+        if ((label == lo) or (label == hi))
+        {
+            this->index_spread(prev, node);
+            label = this->label_of(node);
+        }
+        else
+        {
+            this->key_index->order[node] = label;
+        }
+
+        //the nodes with the same key are ordered by label
+        std::vector<Node<Key, Info> *> &nodes = this->key_index->nodes[node->get_key()];
+        if (nodes.empty() or (this->label_of(nodes.back()) < label))
+        {
+            nodes.push_back(node);
+        }
+        else
+        {
+            nodes.insert(std::upper_bound(nodes.begin(), nodes.end(), label, [this](std::uint64_t l, const Node<Key, Info> *n)
+                                          { return l < this->label_of(n); }),
+                         node);
+        }
+    }
+}
+
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::index_remove(Node<Key, Info> *node)
+{
+    if constexpr (is_hashable<Key>::value)
+    {
+        if (!this->key_index)
+        {
+            return;
+        }
+        auto it = this->key_index->nodes.find(node->get_key());
+        std::vector<Node<Key, Info> *> &nodes = it->second;
+        if (nodes.back() == node)
+        {
+            nodes.pop_back();
+        }
+        else
+        {
+            nodes.erase(std::lower_bound(nodes.begin(), nodes.end(), this->label_of(node), [this](const Node<Key, Info> *n, std::uint64_t l)
+                                         { return this->label_of(n) < l; }));
+        }
+        if (nodes.empty())
+        {
+            this->key_index->nodes.erase(it);
+        }
+        this->key_index->order.erase(node);
+    }
+}
+
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::index_build()
+{
+    if constexpr (is_hashable<Key>::value)
+    {
+        this->key_index->nodes.clear();
+        this->key_index->nodes.reserve(this->length);
+        this->index_relabel();
+        for (Node<Key, Info> *node = this->head; node; node = node->get_next())
+        {
+            this->key_index->nodes[node->get_key()].push_back(node);
+        }
+    }
+}
+
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::index_spread(Node<Key, Info> *prev, Node<Key, Info> *node)
+{
+    if constexpr (is_hashable<Key>::value)
+    {
+        //Dietz and Sleator: the window grows past node until the labels it spans are more than the square of
+        //the nodes in it, which keeps the relabelling at O(log n) amortized; nodes not labelled yet, the rest of
+        //a splice, are taken into the window
+        std::uint64_t lo = prev ? this->label_of(prev) : 0;
+        std::uint64_t nodes = 1;
+        for (Node<Key, Info> *end = node->get_next();; end = end->get_next())
+        {
+            nodes++;
+            std::uint64_t span = UINT64_MAX - lo;
+            if (end)
+            {
+                auto it = this->key_index->order.find(end);
+                if (it == this->key_index->order.end())
+                {
+                    continue;
+                }
+                span = it->second - lo;
+            }
+            if (span / nodes > nodes)
+            {
+                std::uint64_t step = span / nodes;
+                std::uint64_t label = lo;
+                for (Node<Key, Info> *n = node; n != end; n = n->get_next())
+                {
+                    label += step;
+                    this->key_index->order[n] = label;
+                }
+                return;
+            }
+            if (!end)
+            {
+                break;
+            }
+        }
+        //no window fits before the end of the range, so the whole list is relabelled
+        this->index_relabel();
+    }
+}
+
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::index_relabel()
+{
+    if constexpr (is_hashable<Key>::value)
+    {
+        //the labels span the middle half of the range, leaving room at both ends
+        std::uint64_t step = (std::uint64_t(1) << 62) / (std::uint64_t(this->length) + 1);
+        std::uint64_t label = std::uint64_t(1) << 62;
+        this->key_index->order.reserve(this->length);
+        for (Node<Key, Info> *node = this->head; node; node = node->get_next())
+        {
+            label += step;
+            this->key_index->order[node] = label;
+        }
+    }
+}
+
+template <typename Key, typename Info, typename Alloc>
+std::uint64_t Sequence<Key, Info, Alloc>::label_of(const Node<Key, Info> *node) const
+{
+    if constexpr (is_hashable<Key>::value)
+    {
+        return this->key_index->order.find(node)->second;
+    }
+    return 0;
+}
+
+template <typename Key, typename Info, typename Alloc>
+unsigned int Sequence<Key, Info, Alloc>::locate(Node<Key, Info> *target, Node<Key, Info> **prev) const
+{
+    const std::uint64_t label = this->label_of(target);
+    Node<Key, Info> *before = nullptr;
+    unsigned int at = 0;
+    if (this->skip_index)
+    {
+        //the labels grow along the Sequence, so the index is found by bisection
+        unsigned int high = this->length - 1;
+        while (at < high)
+        {
+            unsigned int middle = at + (high - at) / 2;
+            if (this->label_of(this->skip_index->find(this->head, middle)) < label)
+            {
+                at = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        if (prev and at)
+        {
+            before = this->skip_index->find(this->head, at - 1);
+        }
+    }
+    else
+    {
+        //the walk starts from the finger when it is before the node
+        Node<Key, Info> *node = this->head;
+        if (this->finger and (this->label_of(this->finger) < label))
+        {
+            node = this->finger;
+            at = this->finger_index;
+        }
+        for (; node != target; node = node->get_next(), at++)
+        {
+            before = node;
+        }
+    }
+    //the finger goes where the caller will link or unlink a node, as in the walk of find_node
+    if (prev)
+    {
+        *prev = before;
+        if (before)
+        {
+            this->finger = before;
+            this->finger_index = at - 1;
+        }
+    }
+    else
+    {
+        this->finger = target;
+        this->finger_index = at;
+    }
+    return at;
+}
+
+template <typename Key, typename Info, typename Alloc>
+Alloc Sequence<Key, Info, Alloc>::get_allocator() const
+{
+    return this->alloc;
+}
+
+template <typename Key, typename Info, typename Alloc>
+template <typename... Args>
+Node<Key, Info> *Sequence<Key, Info, Alloc>::create_node(Args &&...args)
+{
+    Node<Key, Info> *node = traits::allocate(this->alloc, 1);
+    try
+    {
+        traits::construct(this->alloc, node, std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        traits::deallocate(this->alloc, node, 1);
+        throw;
+    }
+    return node;
+}
+
+template <typename Key, typename Info, typename Alloc>
+void Sequence<Key, Info, Alloc>::destroy_node(Node<Key, Info> *node)
+{
+    traits::destroy(this->alloc, node);
+    traits::deallocate(this->alloc, node, 1);
+}
+
+//Sequence whose nodes come from a std::pmr::memory_resource
+template <typename Key, typename Info>
+using PmrSequence = Sequence<Key, Info, std::pmr::polymorphic_allocator<Node<Key, Info>>>;
@@ -0,0 +1,240 @@
+#pragma once
+#include "node.hpp"
+#include <vector>
+#include <cstdint>
+
+//indexable skip list over the nodes of a singly linked list: the list itself is the bottom level and
+//about a quarter of its nodes get a tower of express links, each storing how many nodes it spans, so
+//the node at an index is found in O(log n) steps; it does not own the nodes and must be told about
+//every node linked in or out
+template <typename Key, typename Info>
+class SkipIndex
+{
+public:
+    SkipIndex();
+    SkipIndex(const SkipIndex<Key, Info> &src) = delete;
+    SkipIndex<Key, Info> &operator=(const SkipIndex<Key, Info> &src) = delete;
+    ~SkipIndex();
+
+    Node<Key, Info> *find(Node<Key, Info> *head, const unsigned int index) const; //returns the node at the given index of the list starting at head, which must be in range
+    void insert(const unsigned int at, Node<Key, Info> *node);                  //records that node was linked in at the given index
+    void erase(const unsigned int at);                                          //records that the node at the given index was linked out
+    void build(Node<Key, Info> *head);                                          //indexes the list starting at head from scratch
+    void clear();                                                               //forgets all the nodes
+
+private:
+    static const unsigned int max_levels = 16; //enough for 4^16 nodes
+
+    struct Tower;
+
+    struct Link
+    {
+        Tower *next;        //next tower at this level, nullptr at the end
+        unsigned int width; //number of nodes from this tower's node to the next one's
+    };
+
+    struct Tower
+    {
+        Node<Key, Info> *node;   //node the tower stands on, nullptr for the head
+        std::vector<Link> links; //express links, lowest level first
+    };
+
+    Tower head;           //tower before the first node, at index -1
+    unsigned int levels;  //levels in use
+    std::uint64_t random; //state of the generator of tower heights
+
+    unsigned int height(); //returns the height of a new tower, 0 for three nodes out of four
+
+    //finds at each level the last tower before the given index and its index
+    void before(const unsigned int at, Tower **update, long *position);
+};
+
+template <typename Key, typename Info>
+SkipIndex<Key, Info>::SkipIndex()
+{
+    this->head.node = nullptr;
+    this->head.links.assign(max_levels, Link{nullptr, 0});
+    this->levels = 0;
+    this->random = 0x9e3779b97f4a7c15ull;
+}
+
+template <typename Key, typename Info>
+SkipIndex<Key, Info>::~SkipIndex()
+{
+    this->clear();
+}
+
+template <typename Key, typename Info>
+Node<Key, Info> *SkipIndex<Key, Info>::find(Node<Key, Info> *head, const unsigned int index) const
+{
+    const Tower *tower = &this->head;
+    long position = -1;
+    for (unsigned int level = this->levels; level-- > 0;)
+    {
+        while (tower->links[level].next and (position + tower->links[level].width <= index))
+        {
+            position += tower->links[level].width;
+            tower = tower->links[level].next;
+        }
+    }
+    //the rest of the way is on the list itself, a few nodes on average
+    Node<Key, Info> *node = head;
+    if (position >= 0)
+    {
+        node = tower->node;
+    }
+    else
+    {
+        position = 0;
+    }
+    for (; position < index; position++)
+    {
+        node = node->get_next();
+    }
+    return node;
+}
+
+template <typename Key, typename Info>
+void SkipIndex<Key, Info>::insert(const unsigned int at, Node<Key, Info> *node)
+{
+    Tower *update[max_levels];
+    long position[max_levels];
+    this->before(at, update, position);
+
+    unsigned int levels = this->height();
+    Tower *tower = nullptr;
+    if (levels)
+    {
+        tower = new Tower{node, std::vector<Link>(levels)};
+        for (; this->levels < levels; this->levels++)
+        {
+            update[this->levels] = &this->head;
+            position[this->levels] = -1;
+        }
+    }
+    for (unsigned int level = 0; level < this->levels; level++)
+    {
+        Link &link = update[level]->links[level];
+        if (level < levels)
+        {
+            //the new tower splits the link; the node after it moved one place further
+            tower->links[level] = Link{link.next, link.next ? unsigned(position[level] + link.width + 1 - at) : 0};
+            link = Link{tower, unsigned(at - position[level])};
+        }
+        else if (link.next)
+        {
+            link.width++;
+        }
+    }
+}
+
+template <typename Key, typename Info>
+void SkipIndex<Key, Info>::erase(const unsigned int at)
+{
+    Tower *update[max_levels];
+    long position[max_levels];
+    this->before(at, update, position);
+
+    Tower *victim = nullptr;
+    for (unsigned int level = 0; level < this->levels; level++)
+    {
+        Link &link = update[level]->links[level];
+        if (link.next and (position[level] + link.width == at))
+        {
+            //the node had a tower, whose links are joined to the ones before it
+            victim = link.next;
+            Link &skipped = victim->links[level];
+            link = Link{skipped.next, skipped.next ? link.width + skipped.width - 1 : 0};
+        }
+        else if (link.next)
+        {
+            link.width--;
+        }
+    }
+    delete victim;
+    while (this->levels and !this->head.links[this->levels - 1].next)
+    {
+        this->levels--;
+    }
+}
+
+template <typename Key, typename Info>
+void SkipIndex<Key, Info>::build(Node<Key, Info> *head)
+{
+    this->clear();
+    Tower *last[max_levels];
+    long position[max_levels];
+    for (unsigned int level = 0; level < max_levels; level++)
+    {
+        last[level] = &this->head;
+        position[level] = -1;
+    }
+    long at = 0;
+    for (Node<Key, Info> *node = head; node; node = node->get_next(), at++)
+    {
+        unsigned int levels = this->height();
+        if (!levels)
+        {
+            continue;
+        }
+        Tower *tower = new Tower{node, std::vector<Link>(levels, Link{nullptr, 0})};
+        for (unsigned int level = 0; level < levels; level++)
+        {
+            last[level]->links[level] = Link{tower, unsigned(at - position[level])};
+            last[level] = tower;
+            position[level] = at;
+        }
+        if (levels > this->levels)
+        {
+            this->levels = levels;
+        }
+    }
+}
+
+template <typename Key, typename Info>
+void SkipIndex<Key, Info>::clear()
+{
+    Tower *tower = this->head.links[0].next;
+    while (tower)
+    {
+        Tower *next = tower->links[0].next;
+        delete tower;
+        tower = next;
+    }
+    this->head.links.assign(max_levels, Link{nullptr, 0});
+    this->levels = 0;
+}
+
+template <typename Key, typename Info>
+unsigned int SkipIndex<Key, Info>::height()
+{
+    //xorshift64, two bits per level
+    this->random ^= this->random << 13;
+    this->random ^= this->random >> 7;
+    this->random ^= this->random << 17;
+    std::uint64_t bits = this->random;
+    unsigned int levels = 0;
+    while ((levels < max_levels) and !(bits & 3))
+    {
+        levels++;
+        bits >>= 2;
+    }
+    return levels;
+}
+
+template <typename Key, typename Info>
+void SkipIndex<Key, Info>::before(const unsigned int at, Tower **update, long *position)
+{
+    Tower *tower = &this->head;
+    long index = -1;
+    for (unsigned int level = this->levels; level-- > 0;)
+    {
+        while (tower->links[level].next and (index + long(tower->links[level].width) < long(at)))
+        {
+            index += tower->links[level].width;
+            tower = tower->links[level].next;
+        }
+        update[level] = tower;
+        position[level] = index;
+    }
+}
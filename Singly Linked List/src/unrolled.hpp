@@ -0,0 +1,717 @@
+#pragma once
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+//Sequence stored as a list of blocks of up to B elements each; a scan reads B elements per
+//pointer it follows, and the per-element overhead is one next pointer per block instead of
+//one per element; blocks split when an insert finds them full and merge with the next block
+//when an erase leaves them less than a quarter full
+template <typename Key, typename Info, unsigned int B = 32>
+class UnrolledSequence
+{
+    static_assert((B >= 8) and (B <= 64), "blocks hold 8 to 64 elements");
+
+public:
+    //element of the sequence, with the accessors of Node
+    class Element
+    {
+    public:
+        const Key &get_key() const { return key; }
+        const Info &get_info() const { return info; }
+        void set_key(const Key &key) { this->key = key; }
+        void set_info(const Info &info) { this->info = info; }
+        bool operator==(const Element &src) const { return (key == src.key) and (info == src.info); }
+        void print() const { std::cout << key << ": " << info << "\n"; }
+
+    private:
+        friend class UnrolledSequence;
+        Element(const Key &key, const Info &info) : key(key), info(info) {}
+        Key key;
+        Info info;
+    };
+
+private:
+    //the elements are built in raw storage as they are added and destroyed as they are removed, so
+    //Key and Info need not be default constructible and removed elements do not linger
+    struct Block
+    {
+        alignas(Element) unsigned char storage[B * sizeof(Element)]; //room for B elements
+        unsigned int used;                                           //elements constructed at the front of storage, never 0 for a block in the list
+        Block *next;
+        Block() : used(0), next(nullptr) {}
+        Block(const Block &src) = delete;
+        ~Block() { std::destroy(this->items(), this->items() + this->used); }
+        Element *items() { return std::launder(reinterpret_cast<Element *>(this->storage)); }
+        const Element *items() const { return std::launder(reinterpret_cast<const Element *>(this->storage)); }
+    };
+
+public:
+    //forward iterator over the elements
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Element;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Element *;
+        using reference = Element &;
+
+        iterator(Block *block = nullptr, unsigned int at = 0) : block(block), at(at) {}
+        reference operator*() const { return block->items()[at]; }
+        pointer operator->() const { return &block->items()[at]; }
+        iterator &operator++()
+        {
+            if (++at == block->used)
+            {
+                block = block->next;
+                at = 0;
+            }
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            iterator it = *this;
+            ++*this;
+            return it;
+        }
+        bool operator==(const iterator &rhs) const { return (block == rhs.block) and (at == rhs.at); }
+        bool operator!=(const iterator &rhs) const { return !(*this == rhs); }
+
+    private:
+        friend class UnrolledSequence;
+        Block *block; //current block, nullptr past the end
+        unsigned int at;
+    };
+
+    //forward iterator over the elements that cannot change them
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Element;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Element *;
+        using reference = const Element &;
+
+        const_iterator(const Block *block = nullptr, unsigned int at = 0) : block(block), at(at) {}
+        const_iterator(const iterator &it) : block(it.block), at(it.at) {}
+        reference operator*() const { return block->items()[at]; }
+        pointer operator->() const { return &block->items()[at]; }
+        const_iterator &operator++()
+        {
+            if (++at == block->used)
+            {
+                block = block->next;
+                at = 0;
+            }
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator it = *this;
+            ++*this;
+            return it;
+        }
+        bool operator==(const const_iterator &rhs) const { return (block == rhs.block) and (at == rhs.at); }
+        bool operator!=(const const_iterator &rhs) const { return !(*this == rhs); }
+
+    private:
+        const Block *block; //current block, nullptr past the end
+        unsigned int at;
+    };
+
+    //default constructor
+    UnrolledSequence();
+
+    //copy constructor
+    UnrolledSequence(const UnrolledSequence<Key, Info, B> &src);
+
+    //destructor
+    ~UnrolledSequence();
+
+    //assignment operator
+    UnrolledSequence<Key, Info, B> &operator=(const UnrolledSequence<Key, Info, B> &src);
+
+    //comparion operator
+    bool operator==(const UnrolledSequence<Key, Info, B> &src) const;
+
+    //capacity
+    bool empty() const;        //returns true if the UnrolledSequence is empty, else return false
+    unsigned int size() const; //returns the size of UnrolledSequence
+
+    //modifiers
+    void push_front(const Key &key, const Info &info);                                                                           //adds element to the front of the UnrolledSequence
+    bool pop_front();                                                                                                            //removes element from the front of the UnrolledSequence and returns true; if UnrolledSequence is empty returns false
+    void push_back(const Key &key, const Info &info);                                                                            //adds element to the back of the UnrolledSequence
+    bool pop_back();                                                                                                             //removes element from the back of the UnrolledSequence and returns true; if UnrolledSequence is empty returns false
+    bool insert_at_pos(const Key &key, const Info &info, const Key &pos, const unsigned int occur = 1, const bool after = true); //inserts element at the given position of the UnrolledSequence and returns true; returns false if position not found
+    bool insert_at_index(const Key &key, const Info &info, const unsigned int index);                                            //inserts element at the given index of the UnrolledSequence and returns true; returns false if index not found
+    bool modify_at_pos(const Info &info, const Key &pos, const unsigned int occur = 1);                                          //modifies the info of the element in the given position of the UnrolledSequence and returns true; returns false if position not found
+    bool modify_at_index(const Info &info, const unsigned int index);                                                            //modifies the info of the element in the given index of the UnrolledSequence and returns true; returns false if index not found
+    bool erase_at_pos(const Key &pos, const unsigned int occur = 1);                                                             //removes the element in the given position of the UnrolledSequence and returns true; returns false if position not found
+    bool erase_at_index(const unsigned int index);                                                                               //removes the element in the given index of the UnrolledSequence and returns true; returns false if index not found
+    void swap(UnrolledSequence<Key, Info, B> &src);                                                                              //swaps the elements of the given source and the object
+    void splice(UnrolledSequence<Key, Info, B> &src);                                                                            //moves all the elements of the given source to the back of the UnrolledSequence without copying them
+    void clear();                                                                                                                //erases all the elements of the list
+    iterator insert_after(iterator position, const Key &key, const Info &info);                                                 //inserts element after the element at the given iterator and returns an iterator to it
+    iterator erase_after(iterator position);                                                                                     //removes the element after the element at the given iterator and returns an iterator to the element that followed it
+
+    //iterators
+    iterator begin() { return iterator(head); }
+    iterator end() { return iterator(); }
+    const_iterator begin() const { return const_iterator(head); }
+    const_iterator end() const { return const_iterator(); }
+    const_iterator cbegin() const { return const_iterator(head); }
+    const_iterator cend() const { return const_iterator(); }
+
+    //operations
+    int get_index(const Key &pos, const unsigned int occur = 1) const;                     //returns the index of the occur-th element with the given key; returns -1 if position not found
+    const Info get(const Key &pos, const unsigned int occur = 1) const;                    //returns the info of the element at the given position; throws and error if position not found
+    const Key key_at(const unsigned int index) const;                                      //returns the key of the element at the given index; throws and error if index out of range
+    const Info info_at(const unsigned int index) const;                                    //returns the info of the element at the given index; throws and error if index out of range
+    const Info *try_get(const Key &pos, const unsigned int occur = 1) const;                //returns a pointer to the info of the element at the given position; returns nullptr if position not found
+    Info get_or(const Key &pos, const Info &fallback, const unsigned int occur = 1) const; //returns the info of the element at the given position; returns fallback if position not found
+    const Key *try_key_at(const unsigned int index) const;                                 //returns a pointer to the key of the element at the given index; returns nullptr if index out of range
+    const Info *try_info_at(const unsigned int index) const;                               //returns a pointer to the info of the element at the given index; returns nullptr if index out of range
+    unsigned int count(const Key &key) const;                                              //returns the number of elements with the given key
+    void print() const;                                                                    //prints all the elements of the UnrolledSequence
+
+private:
+    Block *head;         //first block
+    Block *tail;         //last block
+    unsigned int length; //number of elements
+
+    Element *get_element(const unsigned int index) const;                 //returns the element at the given index; returns nullptr if index is out of range
+    Element *find(const Key &pos, unsigned int occur) const;              //returns the occur-th element with the given key; returns nullptr if there is none
+    Block *locate(unsigned int &index, Block **prev = nullptr) const;     //returns the block holding the given index and turns index into the offset in it; returns nullptr if index is out of range
+    iterator insert_in(Block *block, unsigned int at, const Key &key, const Info &info); //inserts element at the given offset of the given block, splitting it if full
+    iterator erase_in(Block *prev, Block *block, unsigned int at);        //removes the element at the given offset of the given block, merging or unlinking the block
+};
+
+template <typename Key, typename Info, unsigned int B>
+UnrolledSequence<Key, Info, B>::UnrolledSequence()
+{
+    this->head = nullptr;
+    this->tail = nullptr;
+    this->length = 0;
+}
+
+template <typename Key, typename Info, unsigned int B>
+UnrolledSequence<Key, Info, B>::UnrolledSequence(const UnrolledSequence<Key, Info, B> &src)
+{
+    this->head = nullptr;
+    this->tail = nullptr;
+    this->length = 0;
+    *this = src;
+}
+
+template <typename Key, typename Info, unsigned int B>
+UnrolledSequence<Key, Info, B>::~UnrolledSequence()
+{
+    this->clear();
+}
+
+template <typename Key, typename Info, unsigned int B>
+UnrolledSequence<Key, Info, B> &UnrolledSequence<Key, Info, B>::operator=(const UnrolledSequence<Key, Info, B> &src)
+{
+    if (this == &src)
+    {
+        return *this;
+    }
+    this->clear();
+    //copies block by block, so the copy has the layout of the source
+    for (const Block *block = src.head; block; block = block->next)
+    {
+        Block *copy = new Block();
+        std::uninitialized_copy(block->items(), block->items() + block->used, copy->items());
+        copy->used = block->used;
+        if (this->tail)
+        {
+            this->tail->next = copy;
+        }
+        else
+        {
+            this->head = copy;
+        }
+        this->tail = copy;
+    }
+    this->length = src.length;
+    return *this;
+}
+
+template <typename Key, typename Info, unsigned int B>
+bool UnrolledSequence<Key, Info, B>::operator==(const UnrolledSequence<Key, Info, B> &src) const
+{
+    return (this->length == src.length) and std::equal(this->begin(), this->end(), src.begin());
+}
+
+template <typename Key, typename Info, unsigned int B>
+bool UnrolledSequence<Key, Info, B>::empty() const
+{
+    return this->length == 0;
+}
+
+template <typename Key, typename Info, unsigned int B>
+unsigned int UnrolledSequence<Key, Info, B>::size() const
+{
+    return this->length;
+}
+
+template <typename Key, typename Info, unsigned int B>
+void UnrolledSequence<Key, Info, B>::push_front(const Key &key, const Info &info)
+{
+    this->insert_in(this->head, 0, key, info);
+}
+
+template <typename Key, typename Info, unsigned int B>
+bool UnrolledSequence<Key, Info, B>::pop_front()
+{
+    if (this->head)
+    {
+        this->erase_in(nullptr, this->head, 0);
+        return true;
+    }
+    return false;
+}
+
+template <typename Key, typename Info, unsigned int B>
+void UnrolledSequence<Key, Info, B>::push_back(const Key &key, const Info &info)
+{
+    //appending starts a new block instead of splitting, so appended blocks are full
+    if (!this->tail or (this->tail->used == B))
+    {
+        Block *block = new Block();
+        if (this->tail)
+        {
+            this->tail->next = block;
+        }
+        else
+        {
+            this->head = block;
+        }
+        this->tail = block;
+    }
+    new (this->tail->items() + this->tail->used) Element(key, info);
+    this->tail->used++;
+    this->length++;
+}
+
+template <typename Key, typename Info, unsigned int B>
+bool UnrolledSequence<Key, Info, B>::pop_back()
+{
+    if (!this->tail)
+    {
+        return false;
+    }
+    if (this->tail->used > 1)
+    {
+        std::destroy_at(this->tail->items() + --this->tail->used);
+        this->length--;
+        return true;
+    }
+    unsigned int index = this->length - 1;
+    Block *prev = nullptr;
+    Block *block = this->locate(index, &prev);
+    this->erase_in(prev, block, index);
+    return true;
+}
+
+template <typename Key, typename Info, unsigned int B>
+bool UnrolledSequence<Key, Info, B>::insert_at_pos(const Key &key, const Info &info, const Key &pos, const unsigned int occur, const bool after)
+{
+    int index = this->get_index(pos, occur);
+    if (index < 0)
+    {
+        return false;
+    }
+    return this->insert_at_index(key, info, after ? index + 1 : index);
+}
+
+template <typename Key, typename Info, unsigned int B>
+bool UnrolledSequence<Key, Info, B>::insert_at_index(const Key &key, const Info &info, const unsigned int index)
+{
+    if (index > this->length)
+    {
+        return false;
+    }
+    if (index == this->length)
+    {
+        this->push_back(key, info);
+        return true;
+    }
+    unsigned int at = index;
+    Block *block = this->locate(at);
+    this->insert_in(block, at, key, info);
+    return true;
+}
+
+template <typename Key, typename Info, unsigned int B>
+bool UnrolledSequence<Key, Info, B>::modify_at_pos(const Info &info, const Key &pos, const unsigned int occur)
+{
+    Element *element = this->find(pos, occur);
+    if (element)
+    {
+        element->info = info;
+        return true;
+    }
+    return false;
+}
+
+template <typename Key, typename Info, unsigned int B>
+bool UnrolledSequence<Key, Info, B>::modify_at_index(const Info &info, const unsigned int index)
+{
+    Element *element = this->get_element(index);
+    if (element)
+    {
+        element->info = info;
+        return true;
+    }
+    return false;
+}
+
+template <typename Key, typename Info, unsigned int B>
+bool UnrolledSequence<Key, Info, B>::erase_at_pos(const Key &pos, const unsigned int occur)
+{
+    int index = this->get_index(pos, occur);
+    if (index < 0)
+    {
+        return false;
+    }
+    return this->erase_at_index(index);
+}
+
+template <typename Key, typename Info, unsigned int B>
+bool UnrolledSequence<Key, Info, B>::erase_at_index(const unsigned int index)
+{
+    unsigned int at = index;
+    Block *prev = nullptr;
+    Block *block = this->locate(at, &prev);
+    if (block)
+    {
+        this->erase_in(prev, block, at);
+        return true;
+    }
+    return false;
+}
+
+template <typename Key, typename Info, unsigned int B>
+void UnrolledSequence<Key, Info, B>::swap(UnrolledSequence<Key, Info, B> &src)
+{
+    std::swap(this->head, src.head);
+    std::swap(this->tail, src.tail);
+    std::swap(this->length, src.length);
+}
+
+template <typename Key, typename Info, unsigned int B>
+void UnrolledSequence<Key, Info, B>::splice(UnrolledSequence<Key, Info, B> &src)
+{
+    if ((this == &src) or !src.head)
+    {
+        return;
+    }
+    if (this->tail)
+    {
+        this->tail->next = src.head;
+    }
+    else
+    {
+        this->head = src.head;
+    }
+    this->tail = src.tail;
+    this->length += src.length;
+    src.head = nullptr;
+    src.tail = nullptr;
+    src.length = 0;
+}
+
+template <typename Key, typename Info, unsigned int B>
+void UnrolledSequence<Key, Info, B>::clear()
+{
+    Block *block = this->head;
+    while (block)
+    {
+        Block *next = block->next;
+        delete block;
+        block = next;
+    }
+    this->head = nullptr;
+    this->tail = nullptr;
+    this->length = 0;
+}
+
+template <typename Key, typename Info, unsigned int B>
+typename UnrolledSequence<Key, Info, B>::iterator UnrolledSequence<Key, Info, B>::insert_after(iterator position, const Key &key, const Info &info)
+{
+    return this->insert_in(position.block, position.at + 1, key, info);
+}
+
+template <typename Key, typename Info, unsigned int B>
+typename UnrolledSequence<Key, Info, B>::iterator UnrolledSequence<Key, Info, B>::erase_after(iterator position)
+{
+    Block *prev = nullptr;
+    Block *block = position.block;
+    unsigned int at = position.at + 1;
+    if (at == block->used)
+    {
+        prev = block;
+        block = block->next;
+        at = 0;
+    }
+    if (!block)
+    {
+        return end();
+    }
+    return this->erase_in(prev, block, at);
+}
+
+template <typename Key, typename Info, unsigned int B>
+int UnrolledSequence<Key, Info, B>::get_index(const Key &pos, const unsigned int occur) const
+{
+    unsigned int seen = 0;
+    int index = 0;
+    for (const Block *block = this->head; block; block = block->next)
+    {
+        for (unsigned int i = 0; i < block->used; i++)
+        {
+            if ((block->items()[i].key == pos) and (++seen == occur))
+            {
+                return index + i;
+            }
+        }
+        index += block->used;
+    }
+    return -1;
+}
+
+template <typename Key, typename Info, unsigned int B>
+const Info UnrolledSequence<Key, Info, B>::get(const Key &pos, const unsigned int occur) const
+{
+    const Info *info = this->try_get(pos, occur);
+    if (info)
+    {
+        return *info;
+    }
+    throw std::out_of_range("Index out of range");
+}
+
+template <typename Key, typename Info, unsigned int B>
+const Key UnrolledSequence<Key, Info, B>::key_at(const unsigned int index) const
+{
+    const Key *key = this->try_key_at(index);
+    if (key)
+    {
+        return *key;
+    }
+    throw std::out_of_range("Index out of range");
+}
+
+template <typename Key, typename Info, unsigned int B>
+const Info UnrolledSequence<Key, Info, B>::info_at(const unsigned int index) const
+{
+    const Info *info = this->try_info_at(index);
+    if (info)
+    {
+        return *info;
+    }
+    throw std::out_of_range("Index out of range");
+}
+
+template <typename Key, typename Info, unsigned int B>
+const Info *UnrolledSequence<Key, Info, B>::try_get(const Key &pos, const unsigned int occur) const
+{
+    Element *element = this->find(pos, occur);
+    return element ? &element->info : nullptr;
+}
+
+template <typename Key, typename Info, unsigned int B>
+Info UnrolledSequence<Key, Info, B>::get_or(const Key &pos, const Info &fallback, const unsigned int occur) const
+{
+    const Info *info = this->try_get(pos, occur);
+    return info ? *info : fallback;
+}
+
+template <typename Key, typename Info, unsigned int B>
+const Key *UnrolledSequence<Key, Info, B>::try_key_at(const unsigned int index) const
+{
+    Element *element = this->get_element(index);
+    return element ? &element->key : nullptr;
+}
+
+template <typename Key, typename Info, unsigned int B>
+const Info *UnrolledSequence<Key, Info, B>::try_info_at(const unsigned int index) const
+{
+    Element *element = this->get_element(index);
+    return element ? &element->info : nullptr;
+}
+
+template <typename Key, typename Info, unsigned int B>
+unsigned int UnrolledSequence<Key, Info, B>::count(const Key &key) const
+{
+    unsigned int occ = 0;
+    for (const Block *block = this->head; block; block = block->next)
+    {
+        for (unsigned int i = 0; i < block->used; i++)
+        {
+            occ += block->items()[i].key == key;
+        }
+    }
+    return occ;
+}
+
+template <typename Key, typename Info, unsigned int B>
+void UnrolledSequence<Key, Info, B>::print() const
+{
+    for (const Element &element : *this)
+    {
+        element.print();
+    }
+}
+
+template <typename Key, typename Info, unsigned int B>
+typename UnrolledSequence<Key, Info, B>::Element *UnrolledSequence<Key, Info, B>::get_element(const unsigned int index) const
+{
+    unsigned int at = index;
+    Block *block = this->locate(at);
+    return block ? &block->items()[at] : nullptr;
+}
+
+template <typename Key, typename Info, unsigned int B>
+typename UnrolledSequence<Key, Info, B>::Element *UnrolledSequence<Key, Info, B>::find(const Key &pos, unsigned int occur) const
+{
+    for (Block *block = this->head; block; block = block->next)
+    {
+        for (unsigned int i = 0; i < block->used; i++)
+        {
+            if ((block->items()[i].key == pos) and (--occur == 0))
+            {
+                return &block->items()[i];
+            }
+        }
+    }
+    return nullptr;
+}
+
+template <typename Key, typename Info, unsigned int B>
+typename UnrolledSequence<Key, Info, B>::Block *UnrolledSequence<Key, Info, B>::locate(unsigned int &index, Block **prev) const
+{
+    if (index >= this->length)
+    {
+        return nullptr;
+    }
+    //the last block is reached directly, so work at the back stays cheap
+    if (index >= this->length - this->tail->used and !prev)
+    {
+        index -= this->length - this->tail->used;
+        return this->tail;
+    }
+    Block *before = nullptr;
+    Block *block = this->head;
+    while (index >= block->used)
+    {
+        index -= block->used;
+        before = block;
+        block = block->next;
+    }
+    if (prev)
+    {
+        *prev = before;
+    }
+    return block;
+}
+
+template <typename Key, typename Info, unsigned int B>
+typename UnrolledSequence<Key, Info, B>::iterator UnrolledSequence<Key, Info, B>::insert_in(Block *block, unsigned int at, const Key &key, const Info &info)
+{
+    if (!block)
+    {
+        this->push_back(key, info);
+        return iterator(this->tail, this->tail->used - 1);
+    }
+    if (block->used == B)
+    {
+        //move the upper half into a new block after this one
+        Block *half = new Block();
+        std::uninitialized_move(block->items() + B / 2, block->items() + B, half->items());
+        std::destroy(block->items() + B / 2, block->items() + B);
+        half->used = B - B / 2;
+        block->used = B / 2;
+        half->next = block->next;
+        block->next = half;
+        if (this->tail == block)
+        {
+            this->tail = half;
+        }
+        if (at > block->used)
+        {
+            at -= block->used;
+            block = half;
+        }
+    }
+    Element *items = block->items();
+    if (at == block->used)
+    {
+        new (items + at) Element(key, info);
+    }
+    else
+    {
+        //the last element moves into the free slot and the rest shift over
+        new (items + block->used) Element(std::move(items[block->used - 1]));
+        std::move_backward(items + at, items + block->used - 1, items + block->used);
+        items[at].key = key;
+        items[at].info = info;
+    }
+    block->used++;
+    this->length++;
+    return iterator(block, at);
+}
+
+template <typename Key, typename Info, unsigned int B>
+typename UnrolledSequence<Key, Info, B>::iterator UnrolledSequence<Key, Info, B>::erase_in(Block *prev, Block *block, unsigned int at)
+{
+    std::move(block->items() + at + 1, block->items() + block->used, block->items() + at);
+    std::destroy_at(block->items() + --block->used);
+    this->length--;
+    Block *next = block->next;
+    if (next and (block->used < B / 4) and (block->used + next->used <= B))
+    {
+        //merge the next block into this one
+        //the moved-from elements of next are destroyed with it
+        std::uninitialized_move(next->items(), next->items() + next->used, block->items() + block->used);
+        block->used += next->used;
+        block->next = next->next;
+        if (this->tail == next)
+        {
+            this->tail = block;
+        }
+        delete next;
+    }
+    else if (block->used == 0)
+    {
+        //unlink the empty block
+        if (prev)
+        {
+            prev->next = next;
+        }
+        else
+        {
+            this->head = next;
+        }
+        if (this->tail == block)
+        {
+            this->tail = prev;
+        }
+        delete block;
+        return iterator(next);
+    }
+    if (at == block->used)
+    {
+        return iterator(block->next);
+    }
+    return iterator(block, at);
+}
@@ -1,7 +1,13 @@
 #include <utility>
 #include <vector>
 #include <string>
-#include "sequence.hpp"
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <memory>
+#include "join.hpp"
+#include "unrolled.hpp"
+#include "pool.hpp"
 
 //aggregate function
 template <typename Info>
@@ -10,49 +16,43 @@ Info aggregate(const Info &left, const Info &right)
      return left + right;
 }
 
-//join function
-template <typename Key, typename Info>
-Sequence<Key, Info> join(const Sequence<Key, Info> &left, const Sequence<Key, Info> &right, Info (*aggregate)(const Info &left, const Info &right))
+//string that counts how many times it was copied
+struct Counted
 {
-     Sequence<Key, Info> result;
-
-     unsigned int ls = left.size();
-     unsigned int rs = right.size();
-     bool lft = true;
-     if (rs > ls)
-     {
-          lft = false;
-          std::swap(ls, rs);
-     }
-     for (unsigned int i = 0; i < ls; i++)
-     {
-          if (i < rs)
-          {
-               if (left.key_at(i) == right.key_at(i))
-               {
-                    Info new_info = aggregate(left.info_at(i), right.info_at(i));
-                    result.push_back(left.key_at(i), new_info);
-               }
-               else
-               {
-                    result.push_back(left.key_at(i), left.info_at(i));
-                    result.push_back(right.key_at(i), right.info_at(i));
-               }
-          }
-          else
-          {
-               if (lft)
-               {
-                    result.push_back(left.key_at(i), left.info_at(i));
-               }
-               else
-               {
-                    result.push_back(right.key_at(i), right.info_at(i));
-               }
-          }
-     }
-     return result;
-}
+     static unsigned int copies;
+     std::string text;
+     Counted(const char *text) : text(text) {}
+     Counted(const Counted &src) : text(src.text) { copies++; }
+     Counted(Counted &&src) = default;
+     Counted &operator=(const Counted &src)
+     {
+          text = src.text;
+          copies++;
+          return *this;
+     }
+     Counted &operator=(Counted &&src) = default;
+     bool operator==(const Counted &rhs) const { return text == rhs.text; }
+     bool operator!=(const Counted &rhs) const { return text != rhs.text; }
+};
+unsigned int Counted::copies = 0;
+
+//checks if the links or the key of a node can be changed from outside the Sequence
+template <typename T, typename = void>
+struct relinkable : std::false_type
+{
+};
+template <typename T>
+struct relinkable<T, std::void_t<decltype(std::declval<T &>().set_next(nullptr))>> : std::true_type
+{
+};
+template <typename T, typename = void>
+struct rekeyable : std::false_type
+{
+};
+template <typename T>
+struct rekeyable<T, std::void_t<decltype(std::declval<T &>().set_key(std::declval<T &>().get_key()))>> : std::true_type
+{
+};
 
 //creates a Sequence object from the given vector of pairs and returns it
 template <typename Key, typename Info>
@@ -67,21 +67,21 @@ Sequence<Key, Info> vec_to_seq(const std::vector<std::pair<Key, Info>> &src)
 }
 
 //checks if the given Sequence and vector of pairs are equal(have the same elements in the same order)
-template <typename Key, typename Info>
-bool equal(const Sequence<Key, Info> &lhs, const std::vector<std::pair<Key, Info>> &rhs)
+template <typename Key, typename Info, typename Alloc>
+bool equal(const Sequence<Key, Info, Alloc> &lhs, const std::vector<std::pair<Key, Info>> &rhs)
 {
      if (lhs.size() != rhs.size())
      {
           return false;
      }
-     unsigned int i = 0;
+     auto it = lhs.begin();
      for (auto element : rhs)
      {
-          if ((lhs.key_at(i) != element.first) or (lhs.info_at(i) != element.second))
+          if ((it->get_key() != element.first) or (it->get_info() != element.second))
           {
                return false;
           }
-          i++;
+          ++it;
      }
 
      return true;
@@ -1313,4 +1313,879 @@ int main()
                std::cout << "Test 24.3 Failed" << std::endl;
           }
      }
+
+     //Test 25.1 try_get and get_or methods - Non-Empty object | Position exists and does not exist
+     {
+          Sequence<int, std::string> s;
+          s = vec_to_seq<int, std::string>({{1, "English"}, {2, "Polish"}});
+          const std::string *found = s.try_get(2);
+          const std::string *missing = s.try_get(3);
+          if (found and (*found == "Polish") and !missing and (s.get_or(1, "None") == "English") and (s.get_or(3, "None") == "None") and equal(s, {{1, "English"}, {2, "Polish"}}))
+          {
+               std::cout << "Test 25.1 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 25.1 Failed" << std::endl;
+          }
+     }
+
+     //Test 25.2 try_key_at and try_info_at methods - Non-Empty object | Index in and out of range
+     {
+          Sequence<int, std::string> s;
+          s = vec_to_seq<int, std::string>({{1, "English"}, {2, "Polish"}});
+          const int *key = s.try_key_at(1);
+          const std::string *info = s.try_info_at(0);
+          if (key and (*key == 2) and info and (*info == "English") and !s.try_key_at(2) and !s.try_info_at(2) and !Sequence<int, std::string>().try_key_at(0))
+          {
+               std::cout << "Test 25.2 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 25.2 Failed" << std::endl;
+          }
+     }
+
+     //Test 26.1 tail and length bookkeeping - push_back after every modifier that can change the last element
+     {
+          Sequence<int, std::string> s, other;
+          s = vec_to_seq<int, std::string>({{1, "English"}, {2, "Polish"}});
+          s.insert_at_index(3, "French", 2);
+          s.push_back(4, "Spanish");
+          s.erase_at_index(3);
+          s.push_back(5, "German");
+          s.erase_at_pos(5);
+          s.pop_back();
+          s.push_back(6, "Italian");
+          s.insert_at_pos(7, "Dutch", 6);
+          s.push_back(8, "Czech");
+          other.push_back(9, "Greek");
+          s.swap(other);
+          other.push_back(10, "Latin");
+          s.push_back(11, "Welsh");
+          if ((other.size() == 6) and equal(other, {{1, "English"}, {2, "Polish"}, {6, "Italian"}, {7, "Dutch"}, {8, "Czech"}, {10, "Latin"}}) and
+              (s.size() == 2) and equal(s, {{9, "Greek"}, {11, "Welsh"}}))
+          {
+               s.clear();
+               s.push_back(12, "Irish");
+               s.pop_front();
+               s.push_back(13, "Basque");
+               if ((s.size() == 1) and equal(s, {{13, "Basque"}}))
+               {
+                    std::cout << "Test 26.1 Passed" << std::endl;
+               }
+               else
+               {
+                    std::cout << "Test 26.1 Failed" << std::endl;
+               }
+          }
+          else
+          {
+               std::cout << "Test 26.1 Failed" << std::endl;
+          }
+     }
+
+     //Test 26.2 push_back method - Many elements
+     {
+          Sequence<int, int> s;
+          for (int i = 0; i < 1000000; i++)
+          {
+               s.push_back(i, i);
+          }
+          Sequence<int, int> copy(s);
+          copy.push_back(-1, -1);
+          if ((s.size() == 1000000) and (copy.size() == 1000001) and (s.key_at(999999) == 999999) and (copy.key_at(1000000) == -1))
+          {
+               std::cout << "Test 26.2 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 26.2 Failed" << std::endl;
+          }
+     }
+
+     //Test 27.1 iterators - Range-for and standard algorithms
+     {
+          Sequence<int, std::string> s;
+          s = vec_to_seq<int, std::string>({{1, "English"}, {2, "Polish"}, {3, "French"}});
+          std::string all;
+          for (const auto &node : s)
+          {
+               all += node.get_info();
+          }
+          for (auto &node : s)
+          {
+               node.set_info(node.get_info() + "!");
+          }
+          auto found = std::find_if(s.cbegin(), s.cend(), [](const Node<int, std::string> &node)
+                                    { return node.get_key() == 2; });
+          bool forward = std::is_same<std::iterator_traits<Sequence<int, std::string>::iterator>::iterator_category, std::forward_iterator_tag>::value;
+          if ((all == "EnglishPolishFrench") and (found != s.cend()) and (found->get_info() == "Polish!") and (std::distance(s.begin(), s.end()) == 3) and
+              forward and (Sequence<int, std::string>().begin() == Sequence<int, std::string>().end()) and
+              not relinkable<Node<int, std::string>>::value and not rekeyable<Node<int, std::string>>::value)
+          {
+               std::cout << "Test 27.1 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 27.1 Failed" << std::endl;
+          }
+     }
+
+     //Test 27.2 insert_after and erase_after methods - Middle and last element
+     {
+          Sequence<int, std::string> s;
+          s = vec_to_seq<int, std::string>({{1, "English"}, {2, "Polish"}});
+          auto it = s.insert_after(s.begin(), 3, "French");
+          auto last = s.insert_after(++it, 4, "Spanish");
+          s.push_back(5, "German");
+          auto next = s.erase_after(s.begin());
+          auto end = s.erase_after(last); //removes the last element
+          auto past = s.erase_after(last); //nothing after the last element
+          s.push_back(6, "Italian");
+          if ((s.size() == 4) and equal(s, {{1, "English"}, {2, "Polish"}, {4, "Spanish"}, {6, "Italian"}}) and (next->get_key() == 2) and
+              (end == s.end()) and (past == s.end()))
+          {
+               std::cout << "Test 27.2 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 27.2 Failed" << std::endl;
+          }
+     }
+
+     //Test 27.3 join function - Large objects
+     {
+          Sequence<int, int> left, right, result;
+          for (int i = 0; i < 1000000; i++)
+          {
+               left.push_back(i, 1);
+               right.push_back(i % 2 ? i : -i, 2);
+          }
+          result = join(left, right, &aggregate);
+          if ((result.size() == 1499999) and (result.key_at(0) == 0) and (result.info_at(0) == 3) and (result.key_at(1) == 1) and (result.info_at(1) == 3))
+          {
+               std::cout << "Test 27.3 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 27.3 Failed" << std::endl;
+          }
+     }
+
+     //Test 28.1 join function - Aggregator policies and lambdas
+     {
+          Sequence<int, int> left, right;
+          left = vec_to_seq<int, int>({{1, 5}, {2, 1}, {3, 7}});
+          right = vec_to_seq<int, int>({{1, 2}, {2, 4}, {4, 9}, {5, 6}});
+          Sequence<int, int> sum = join(left, right, SumAggregate());
+          Sequence<int, int> max = join(left, right, MaxAggregate());
+          int calls = 0;
+          Sequence<int, int> product = join(left, right, [&calls](const int &l, const int &r)
+                                            { calls++;
+                                              return l * r; });
+          if (equal(sum, {{1, 7}, {2, 5}, {3, 7}, {4, 9}, {5, 6}}) and equal(max, {{1, 5}, {2, 4}, {3, 7}, {4, 9}, {5, 6}}) and
+              equal(product, {{1, 10}, {2, 4}, {3, 7}, {4, 9}, {5, 6}}) and (calls == 2) and (product.size() == 5))
+          {
+               std::cout << "Test 28.1 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 28.1 Failed" << std::endl;
+          }
+     }
+
+     //Test 29.1 splice method - Non-Empty objects
+     {
+          Sequence<int, std::string> s, src, empty;
+          s = vec_to_seq<int, std::string>({{1, "English"}});
+          src = vec_to_seq<int, std::string>({{2, "Polish"}, {3, "French"}});
+          s.splice(src);
+          s.splice(empty);
+          s.push_back(4, "Spanish");
+          empty.splice(s);
+          if ((s.size() == 0) and s.empty() and (src.size() == 0) and (empty.size() == 4) and equal(empty, {{1, "English"}, {2, "Polish"}, {3, "French"}, {4, "Spanish"}}))
+          {
+               std::cout << "Test 29.1 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 29.1 Failed" << std::endl;
+          }
+     }
+
+     //Test 29.2 join_many function - Several objects of different sizes
+     {
+          std::vector<Sequence<int, int>> parts(3);
+          parts[0] = vec_to_seq<int, int>({{1, 1}, {2, 2}, {3, 3}});
+          parts[1] = vec_to_seq<int, int>({{1, 10}, {5, 20}});
+          parts[2] = vec_to_seq<int, int>({{1, 100}, {2, 200}, {3, 300}, {4, 400}});
+          Sequence<int, int> result = join_many(parts, SumAggregate());
+          Sequence<int, int> pair = join_many(parts.data(), 2, SumAggregate());
+          if (equal(result, {{1, 111}, {2, 202}, {5, 20}, {3, 303}, {4, 400}}) and (pair == join(parts[0], parts[1], SumAggregate())) and
+              (join_many(parts.data(), 0, SumAggregate()).size() == 0))
+          {
+               std::cout << "Test 29.2 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 29.2 Failed" << std::endl;
+          }
+     }
+
+     //Test 29.3 join_many function - Large objects on several threads
+     {
+          std::vector<Sequence<int, int>> parts(8);
+          for (int p = 0; p < 8; p++)
+          {
+               for (int i = 0; i < 300000 + p * 1000; i++)
+               {
+                    parts[p].push_back(i % (p + 2), 1);
+               }
+          }
+          Sequence<int, int> single = join_many(parts, SumAggregate(), 1);
+          Sequence<int, int> parallel = join_many(parts, SumAggregate(), 4);
+          if ((single == parallel) and (parallel.key_at(0) == 0) and (parallel.info_at(0) == 8))
+          {
+               std::cout << "Test 29.3 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 29.3 Failed" << std::endl;
+          }
+     }
+
+     //Test 29.4 join_many function - Large objects with a pool allocator
+     {
+          NodePool<Node<int, int>> pool;
+          std::vector<Sequence<int, int, PoolAllocator<Node<int, int>>>> parts;
+          for (int p = 0; p < 4; p++)
+          {
+               parts.emplace_back(PoolAllocator<Node<int, int>>(pool));
+               for (int i = 0; i < 200000; i++)
+               {
+                    parts[p].push_back(i % (p + 2), 1);
+               }
+          }
+          Sequence<int, int, PoolAllocator<Node<int, int>>> result = join_many(parts, SumAggregate(), 4);
+          std::size_t live = pool.live();
+          Sequence<int, int, PoolAllocator<Node<int, int>>> again = join_many(parts, SumAggregate(), 1);
+          if ((result == again) and (result.key_at(0) == 0) and (result.info_at(0) == 4) and (live == 800000 + result.size()) and
+              (pool.live() == 800000 + 2 * result.size()))
+          {
+               std::cout << "Test 29.4 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 29.4 Failed" << std::endl;
+          }
+     }
+
+     //Test 30.1 UnrolledSequence - Random operations against a vector
+     {
+          UnrolledSequence<int, int, 8> s;
+          std::vector<std::pair<int, int>> model;
+          unsigned int seed = 7;
+          bool same = true;
+          for (int step = 0; (step < 20000) and same; step++)
+          {
+               seed = seed * 1103515245 + 12345;
+               unsigned int op = (seed >> 16) % 8;
+               unsigned int index = model.empty() ? 0 : (seed >> 8) % (model.size() + 1);
+               int key = step % 13;
+               if ((op == 0) or (op == 1))
+               {
+                    same = s.insert_at_index(key, step, index);
+                    model.insert(model.begin() + index, {key, step});
+               }
+               else if ((op == 2) and (index < model.size()))
+               {
+                    same = s.erase_at_index(index);
+                    model.erase(model.begin() + index);
+               }
+               else if (op == 3)
+               {
+                    s.push_back(key, step);
+                    model.push_back({key, step});
+               }
+               else if ((op == 4) and !model.empty())
+               {
+                    same = s.pop_front();
+                    model.erase(model.begin());
+               }
+               else if ((op == 5) and !model.empty())
+               {
+                    same = s.pop_back();
+                    model.pop_back();
+               }
+               else if ((op == 6) and (index < model.size()))
+               {
+                    auto it = s.begin();
+                    std::advance(it, index);
+                    if (index + 1 < model.size())
+                    {
+                         s.erase_after(it);
+                         model.erase(model.begin() + index + 1);
+                    }
+                    else
+                    {
+                         s.insert_after(it, key, step);
+                         model.push_back({key, step});
+                    }
+               }
+               else if ((op == 7) and (index < model.size()))
+               {
+                    same = s.modify_at_index(-step, index);
+                    model[index].second = -step;
+               }
+               same = same and (s.size() == model.size()) and (unsigned(std::distance(s.begin(), s.end())) == model.size());
+          }
+          auto it = s.cbegin();
+          for (auto element : model)
+          {
+               same = same and (it->get_key() == element.first) and (it->get_info() == element.second);
+               ++it;
+          }
+          if (same and (it == s.cend()))
+          {
+               std::cout << "Test 30.1 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 30.1 Failed" << std::endl;
+          }
+     }
+
+     //Test 30.2 UnrolledSequence - Position based methods and copies
+     {
+          UnrolledSequence<int, std::string> s;
+          s.push_back(1, "English");
+          s.push_back(2, "Polish");
+          s.push_back(1, "Spanish");
+          s.insert_at_pos(3, "French", 1, 2, false);
+          s.modify_at_pos("German", 2);
+          UnrolledSequence<int, std::string> copy(s);
+          copy.erase_at_pos(1, 2);
+          bool positions = (s.get_index(1, 2) == 3) and (s.get(1, 2) == "Spanish") and (s.count(1) == 2) and (s.key_at(2) == 3) and (s.info_at(1) == "German");
+          bool copies = (copy.size() == 3) and (copy.get_or(1, "None", 2) == "None") and !(copy == s) and (UnrolledSequence<int, std::string>(s) == s);
+          bool misses = !s.try_get(4) and !s.try_key_at(4) and (s.get_index(1, 3) == -1);
+          try
+          {
+               s.info_at(4);
+               misses = false;
+          }
+          catch (const std::out_of_range &error)
+          {
+          }
+          if (positions and copies and misses)
+          {
+               std::cout << "Test 30.2 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 30.2 Failed" << std::endl;
+          }
+     }
+
+     //Test 30.3 UnrolledSequence - Elements without a default constructor are destroyed on removal
+     {
+          std::shared_ptr<int> shared = std::make_shared<int>(7);
+          bool released;
+          {
+               UnrolledSequence<Counted, std::shared_ptr<int>, 8> s;
+               for (int i = 0; i < 100; i++)
+               {
+                    s.push_back(i % 2 ? "odd" : "even", shared);
+               }
+               s.insert_at_index("middle", shared, 50);
+               for (int i = 0; i < 40; i++)
+               {
+                    s.pop_back();
+                    s.erase_at_index(10);
+               }
+               UnrolledSequence<Counted, std::shared_ptr<int>, 8> copy(s);
+               copy.erase_at_pos("middle");
+               released = (s.size() == 21) and (shared.use_count() == 1 + 21 + 20) and (s.get_index("middle") == 10) and (copy.count("middle") == 0);
+               while (s.pop_front())
+               {
+               }
+               released = released and (shared.use_count() == 1 + 20);
+          }
+          if (released and (shared.use_count() == 1))
+          {
+               std::cout << "Test 30.3 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 30.3 Failed" << std::endl;
+          }
+     }
+
+     //Test 31.1 PoolAllocator - Recycling nodes and clearing at once
+     {
+          NodePool<Node<int, int>> pool(256);
+          Sequence<int, int, PoolAllocator<Node<int, int>>> s(pool);
+          for (int i = 0; i < 1000; i++)
+          {
+               s.push_back(i, i);
+          }
+          unsigned int chunks = pool.chunks();
+          for (int i = 0; i < 500; i++)
+          {
+               s.pop_front();
+               s.push_back(i, -i);
+          }
+          bool recycled = (pool.chunks() == chunks) and (pool.live() == 1000) and (s.size() == 1000) and (s.key_at(999) == 499) and (s.info_at(999) == -499);
+          Sequence<int, int, PoolAllocator<Node<int, int>>> copy(s);
+          chunks = pool.chunks();
+          s.clear();
+          bool shared = (pool.live() == 1000) and (copy.size() == 1000) and (copy.info_at(999) == -499);
+          copy.clear();
+          bool cleared = (pool.live() == 0) and copy.empty() and (pool.chunks() == chunks);
+          copy.push_back(1, 1);
+          if (recycled and shared and cleared and equal(copy, {{1, 1}}))
+          {
+               std::cout << "Test 31.1 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 31.1 Failed" << std::endl;
+          }
+     }
+
+     //Test 31.2 PmrSequence and splice between allocators
+     {
+          char buffer[4096];
+          std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+          PmrSequence<int, std::string> s(&arena);
+          s.push_back(1, "English");
+          s.push_back(2, "Polish");
+          PmrSequence<int, std::string> other;
+          other.push_back(3, "French");
+          s.splice(other);
+          NodePool<Node<int, std::string>> first, second;
+          Sequence<int, std::string, PoolAllocator<Node<int, std::string>>> a(first), b(second);
+          a.push_back(4, "Spanish");
+          b.push_back(5, "German");
+          a.splice(b);
+          a.swap(b);
+          b.push_back(6, "Italian");
+          if (equal(s, {{1, "English"}, {2, "Polish"}, {3, "French"}}) and other.empty() and (s.get_allocator().resource() == &arena) and
+              a.empty() and equal(b, {{4, "Spanish"}, {5, "German"}, {6, "Italian"}}) and (first.live() == 3) and (second.live() == 0))
+          {
+               std::cout << "Test 31.2 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 31.2 Failed" << std::endl;
+          }
+     }
+
+     //Test 32.1 Move Constructor and Move Assignment - Nodes change hands
+     {
+          Sequence<int, std::string> src = vec_to_seq<int, std::string>({{1, "English"}, {2, "Polish"}});
+          const std::string *info = &src.begin()->get_info();
+          Sequence<int, std::string> s(std::move(src));
+          bool constructed = src.empty() and (src.size() == 0) and (&s.begin()->get_info() == info);
+          src.push_back(3, "French");
+          Sequence<int, std::string> other = vec_to_seq<int, std::string>({{4, "Spanish"}});
+          other = std::move(s);
+          bool assigned = s.empty() and (&other.begin()->get_info() == info) and equal(other, {{1, "English"}, {2, "Polish"}});
+          other = std::move(other);
+          s = std::move(src);
+          if (constructed and assigned and equal(other, {{1, "English"}, {2, "Polish"}}) and equal(s, {{3, "French"}}) and src.empty() and std::is_nothrow_move_constructible<Sequence<int, std::string>>::value)
+          {
+               std::cout << "Test 32.1 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 32.1 Failed" << std::endl;
+          }
+     }
+
+     //Test 32.2 Emplace and rvalue push - No copies of the elements
+     {
+          Counted::copies = 0;
+          Sequence<Counted, Counted> s;
+          s.emplace_back("b", "Polish");
+          s.emplace_front("a", "English");
+          s.push_back(Counted("d"), Counted("Spanish"));
+          s.push_front(Counted("0"), Counted("German"));
+          bool inserted = s.emplace_at_index(3, "c", "French") and !s.emplace_at_index(6, "x", "Italian");
+          Sequence<Counted, Counted> moved(std::move(s));
+          unsigned int copies = Counted::copies;
+          Counted key("e");
+          moved.push_back(key, Counted("Czech"));
+          if (inserted and (copies == 0) and (Counted::copies == 2) and (moved.size() == 6) and (moved.key_at(3) == Counted("c")) and (moved.info_at(4) == Counted("Spanish")))
+          {
+               std::cout << "Test 32.2 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 32.2 Failed" << std::endl;
+          }
+     }
+
+     //Test 32.3 Assignment Operator - Nodes are reused
+     {
+          Sequence<int, std::string> s = vec_to_seq<int, std::string>({{1, "English"}, {2, "Polish"}, {3, "French"}});
+          const std::string *info = &s.begin()->get_info();
+          Sequence<int, std::string> shorter = vec_to_seq<int, std::string>({{4, "Spanish"}, {5, "German"}});
+          Sequence<int, std::string> longer = vec_to_seq<int, std::string>({{6, "Italian"}, {7, "Czech"}, {8, "Dutch"}, {9, "Greek"}});
+          s = shorter;
+          bool shrunk = equal(s, {{4, "Spanish"}, {5, "German"}}) and (&s.begin()->get_info() == info);
+          s.push_back(10, "Danish");
+          s = longer;
+          bool grown = equal(s, {{6, "Italian"}, {7, "Czech"}, {8, "Dutch"}, {9, "Greek"}}) and (&s.begin()->get_info() == info);
+          s.push_back(11, "Irish");
+          s = s;
+          Sequence<int, std::string> empty;
+          shorter = empty;
+          shorter.push_back(12, "Welsh");
+          if (shrunk and grown and (s.size() == 5) and equal(shorter, {{12, "Welsh"}}))
+          {
+               std::cout << "Test 32.3 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 32.3 Failed" << std::endl;
+          }
+     }
+
+     //Test 33.1 get_index - Later occurrences of a key
+     {
+          Sequence<int, std::string> s = vec_to_seq<int, std::string>({{1, "English"}, {2, "Polish"}, {1, "French"}, {3, "Spanish"}, {1, "German"}});
+          if ((s.get_index(1) == 0) and (s.get_index(1, 2) == 2) and (s.get_index(1, 3) == 4) and (s.get_index(1, 4) == -1) and (s.get_index(1, 0) == -1) and
+              (s.get(1, 3) == "German") and s.erase_at_pos(1, 2) and s.insert_at_pos(4, "Italian", 1, 2, false) and
+              equal(s, {{1, "English"}, {2, "Polish"}, {3, "Spanish"}, {4, "Italian"}, {1, "German"}}))
+          {
+               std::cout << "Test 33.1 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 33.1 Failed" << std::endl;
+          }
+     }
+
+     //Test 33.2 Key Index - Same answers as the walk after every kind of modification
+     {
+          Sequence<int, int> plain;
+          Sequence<int, int> s;
+          s.enable_index();
+          bool same = s.indexed() and !plain.indexed();
+          for (int i = 0; (i < 2000) and same; i++)
+          {
+               int key = i * 7 % 13;
+               switch (i % 12)
+               {
+               case 0:
+                    plain.push_front(key, i);
+                    s.push_front(key, i);
+                    break;
+               case 1:
+               case 2:
+                    plain.push_back(key, i);
+                    s.push_back(key, i);
+                    break;
+               case 3:
+                    same = plain.insert_at_pos(key, i, i % 5, 2, i % 2) == s.insert_at_pos(key, i, i % 5, 2, i % 2);
+                    break;
+               case 4:
+                    same = plain.emplace_at_index(i % 50, key, i) == s.emplace_at_index(i % 50, key, i);
+                    break;
+               case 5:
+                    same = plain.erase_at_pos(key, 3) == s.erase_at_pos(key, 3);
+                    break;
+               case 6:
+                    same = plain.erase_at_index(i % 40) == s.erase_at_index(i % 40);
+                    break;
+               case 7:
+                    plain.insert_after(std::next(plain.begin(), plain.size() / 2), key, i);
+                    s.insert_after(std::next(s.begin(), s.size() / 2), key, i);
+                    break;
+               case 8:
+                    plain.erase_after(std::next(plain.begin(), plain.size() / 3));
+                    s.erase_after(std::next(s.begin(), s.size() / 3));
+                    break;
+               case 9:
+                    plain.pop_back();
+                    s.pop_back();
+                    break;
+               case 10:
+               {
+                    Sequence<int, int> tail = vec_to_seq<int, int>({{key, i}, {5, i}});
+                    Sequence<int, int> indexed_tail(tail);
+                    indexed_tail.enable_index();
+                    plain.splice(tail);
+                    s.splice(indexed_tail);
+                    same = indexed_tail.empty() and (indexed_tail.count(key) == 0);
+                    break;
+               }
+               default:
+                    same = plain.modify_at_pos(-i, key, 2) == s.modify_at_pos(-i, key, 2);
+                    break;
+               }
+               if (i % 100 == 99)
+               {
+                    Sequence<int, int> copy(s);
+                    s = std::move(copy);
+               }
+               for (int k = 0; (k < 13) and same; k++)
+               {
+                    unsigned int occurrences = plain.count(k);
+                    same = (s.count(k) == occurrences) and (s.get_index(k, occurrences) == plain.get_index(k, occurrences)) and
+                           (s.get_index(k, occurrences + 1) == -1) and (s.get_or(k, 0, 1) == plain.get_or(k, 0, 1));
+               }
+          }
+          same = same and s.indexed() and (s == plain);
+          s.clear();
+          same = same and (s.count(1) == 0) and (s.get_index(1) == -1);
+          s.disable_index();
+          if (same and !s.indexed())
+          {
+               std::cout << "Test 33.2 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 33.2 Failed" << std::endl;
+          }
+     }
+
+     //Test 33.3 Key Index - Later occurrences and inserts in the middle, with and without the position index
+     {
+          bool same = true;
+          for (int positions = 0; (positions < 2) and same; positions++)
+          {
+               Sequence<int, std::string> s = vec_to_seq<int, std::string>({{1, "English"}, {2, "Polish"}, {1, "French"}, {3, "Spanish"}, {1, "German"}});
+               s.enable_index();
+               if (positions)
+               {
+                    s.enable_position_index();
+               }
+               same = (s.get_index(1, 2) == 2) and (s.get_index(1, 3) == 4) and (s.get_index(1, 4) == -1) and s.insert_at_pos(1, "Italian", 3, 1, true) and
+                      (s.get_index(1, 3) == 4) and (s.get(1, 3) == "Italian") and (s.get(1, 4) == "German") and s.insert_at_pos(1, "Czech", 2, 1, false) and
+                      (s.get_index(1, 2) == 1) and (s.get(1, 3) == "French");
+               //inserting again and again at one place runs out of room between the labels around it
+               for (int i = 0; (i < 200) and same; i++)
+               {
+                    same = s.insert_at_pos(1, std::to_string(i), 2, 1, true) and (s.get_index(1, 3) == 3) and (s.get(1, 3) == std::to_string(i)) and
+                           (s.get_index(1, i + 6) == int(s.size()) - 1);
+               }
+          }
+          if (same)
+          {
+               std::cout << "Test 33.3 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 33.3 Failed" << std::endl;
+          }
+     }
+
+     //Test 33.4 Key Index - Many inserts after one node relabel only around it
+     {
+          Sequence<int, int> plain;
+          Sequence<int, int> s;
+          s.enable_index();
+          for (int i = 0; i < 1000; i++)
+          {
+               plain.push_back(i, i);
+               s.push_back(i, i);
+          }
+          bool same = true;
+          for (int i = 0; (i < 5000) and same; i++)
+          {
+               int key = -(i % 3);
+               plain.insert_at_pos(key, i, 500, 1, true);
+               same = s.insert_at_pos(key, i, 500, 1, true) and (s.get_index(key, 2) == plain.get_index(key, 2)) and
+                      (s.get_index(key, s.count(key)) == plain.get_index(key, plain.count(key)));
+               if (i % 1000 == 999)
+               {
+                    s.push_front(key, i);
+                    plain.push_front(key, i);
+               }
+          }
+          if (same and (s == plain) and (s.get_index(999) == plain.get_index(999)) and (s.get(0, 2) == plain.get(0, 2)))
+          {
+               std::cout << "Test 33.4 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 33.4 Failed" << std::endl;
+          }
+     }
+
+     //Test 34.1 Position Index - Same elements at every index after every kind of modification
+     {
+          Sequence<int, int> plain;
+          Sequence<int, int> s;
+          s.enable_position_index();
+          bool same = s.position_indexed() and !plain.position_indexed();
+          for (int i = 0; (i < 3000) and same; i++)
+          {
+               int key = i * 7 % 13;
+               unsigned int size = plain.size();
+               switch (i % 12)
+               {
+               case 0:
+                    plain.push_front(key, i);
+                    s.push_front(key, i);
+                    break;
+               case 1:
+               case 2:
+                    plain.push_back(key, i);
+                    s.push_back(key, i);
+                    break;
+               case 3:
+                    same = plain.insert_at_pos(key, i, i % 5, 2, i % 2) == s.insert_at_pos(key, i, i % 5, 2, i % 2);
+                    break;
+               case 4:
+                    same = plain.insert_at_index(key, i, i * 31 % (size + 2)) == s.insert_at_index(key, i, i * 31 % (size + 2));
+                    break;
+               case 5:
+                    same = plain.erase_at_pos(key, 2) == s.erase_at_pos(key, 2);
+                    break;
+               case 6:
+                    same = plain.erase_at_index(i * 17 % (size + 1)) == s.erase_at_index(i * 17 % (size + 1));
+                    break;
+               case 7:
+                    if (size)
+                    {
+                         plain.insert_after(std::next(plain.begin(), size / 2), key, i);
+                         s.insert_after(std::next(s.begin(), size / 2), key, i);
+                    }
+                    break;
+               case 8:
+                    if (size)
+                    {
+                         plain.erase_after(std::next(plain.begin(), size / 3));
+                         s.erase_after(std::next(s.begin(), size / 3));
+                    }
+                    break;
+               case 9:
+                    same = plain.pop_back() == s.pop_back();
+                    break;
+               case 10:
+               {
+                    Sequence<int, int> tail = vec_to_seq<int, int>({{key, i}, {5, i}});
+                    Sequence<int, int> indexed_tail(tail);
+                    indexed_tail.enable_position_index();
+                    plain.splice(tail);
+                    s.splice(indexed_tail);
+                    same = indexed_tail.empty() and !indexed_tail.try_key_at(0);
+                    break;
+               }
+               default:
+                    same = plain.modify_at_index(-i, i % (size + 1)) == s.modify_at_index(-i, i % (size + 1));
+                    break;
+               }
+               if (i % 100 == 99)
+               {
+                    Sequence<int, int> copy(s);
+                    s = std::move(copy);
+               }
+               if (i % 10 == 0)
+               {
+                    for (unsigned int index = 0; (index <= plain.size()) and same; index++)
+                    {
+                         const int *key = s.try_key_at(index);
+                         const int *info = s.try_info_at(index);
+                         same = (index == plain.size()) ? (!key and !info) : (key and info and (*key == plain.key_at(index)) and (*info == plain.info_at(index)));
+                    }
+               }
+          }
+          same = same and s.position_indexed() and (s == plain) and (plain.size() > 100);
+          s.clear();
+          same = same and !s.try_key_at(0);
+          s.push_back(1, 1);
+          s.disable_position_index();
+          if (same and !s.position_indexed() and (s.key_at(0) == 1))
+          {
+               std::cout << "Test 34.1 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 34.1 Failed" << std::endl;
+          }
+     }
+
+     //Test 35.1 Finger - Positional reads in any order around modifications
+     {
+          Sequence<int, int> s;
+          std::vector<int> infos;
+          bool same = true;
+          for (int i = 0; (i < 400) and same; i++)
+          {
+               unsigned int size = infos.size();
+               unsigned int at = i * 37 % (size + 1);
+               switch (i % 8)
+               {
+               case 0:
+               case 1:
+                    s.push_back(i % 13, i);
+                    infos.push_back(i);
+                    break;
+               case 2:
+                    s.insert_at_index(i % 13, i, at);
+                    infos.insert(infos.begin() + at, i);
+                    break;
+               case 3:
+                    if (s.erase_at_index(at))
+                    {
+                         infos.erase(infos.begin() + at);
+                    }
+                    break;
+               case 4:
+                    s.push_front(i % 13, i);
+                    infos.insert(infos.begin(), i);
+                    break;
+               case 5:
+                    if (size > 1)
+                    {
+                         s.insert_after(std::next(s.begin(), at % size), i % 13, i);
+                         infos.insert(infos.begin() + at % size + 1, i);
+                    }
+                    break;
+               case 6:
+               {
+                    int index = s.get_index(i % 13, 2);
+                    if (s.erase_at_pos(i % 13, 2))
+                    {
+                         infos.erase(infos.begin() + index);
+                    }
+                    break;
+               }
+               default:
+                    if (s.pop_back())
+                    {
+                         infos.pop_back();
+                    }
+                    break;
+               }
+               //forwards, backwards and from the middle, so the finger is reused and restarted
+               for (unsigned int index = 0; (index < infos.size()) and same; index++)
+               {
+                    same = s.info_at(index) == infos[index];
+               }
+               for (unsigned int index = infos.size(); (index-- > 0) and same;)
+               {
+                    same = s.info_at(index) == infos[index];
+               }
+               same = same and (s.size() == infos.size()) and !s.try_info_at(infos.size()) and (infos.empty() or (s.info_at(infos.size() / 2) == infos[infos.size() / 2]));
+          }
+          Sequence<int, int> other;
+          other.push_back(1, 1);
+          other.info_at(0);
+          s.info_at(s.size() - 1);
+          s.swap(other);
+          same = same and (s.info_at(0) == 1) and (other.info_at(other.size() - 1) == infos.back());
+          if (same)
+          {
+               std::cout << "Test 35.1 Passed" << std::endl;
+          }
+          else
+          {
+               std::cout << "Test 35.1 Failed" << std::endl;
+          }
+     }
 }